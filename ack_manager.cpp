@@ -0,0 +1,248 @@
+/**
+ * @file	ack_manager.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "ack_manager.hpp"
+
+namespace stomp {
+
+	AckManager::AckManager(Client* client, size_t max_batch, int flush_interval_ms)
+		: client_(client),
+		max_batch_(max_batch ? max_batch : 1),
+		flush_interval_(std::chrono::milliseconds(flush_interval_ms)),
+		unsent_count_(0)
+	{
+	}
+
+	AckManager::~AckManager()
+	{
+		flush();
+	}
+
+	const char* AckManager::mode_name(Mode mode)
+	{
+		return (mode == MODE_CLIENT_INDIVIDUAL) ? "client-individual" : "client";
+	}
+
+	command::Subscribe::Handle AckManager::bind(command::Subscribe& subscribe, Mode mode, const std::shared_ptr<SubscriptionHandler>& handler, bool auto_ack)
+	{
+		subscribe.ack(mode_name(mode));
+		track(subscribe.id(), mode);
+		return subscribe.bind(std::make_shared<TrackingHandler>(this, handler, auto_ack));
+	}
+
+	int AckManager::TrackingHandler::onMessage(Frame* frame)
+	{
+		int rc;
+		manager_->delivered(frame);
+		rc = handler_->onMessage(frame);
+		if (!auto_ack_)
+			return rc;
+		// A message left unacknowledged would hold back every later ack:client ACK
+		if (!rc)
+			manager_->ack(frame);
+		else
+			manager_->nack(frame);
+		return rc;
+	}
+
+	void AckManager::track(const std::string& subscription, Mode mode)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		Subscription& item = subscriptions_[subscription];
+		item.mode = mode;
+		item.messages.clear();
+	}
+
+	void AckManager::untrack(const std::string& subscription)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		flush_locked();
+		subscriptions_.erase(subscription);
+	}
+
+	void AckManager::delivered(const Frame* message)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		std::unordered_map<std::string, Subscription>::iterator iter = subscriptions_.find(message->subscription());
+		Message item;
+		if ((iter == subscriptions_.end()) || (iter->second.mode != MODE_CLIENT))
+			return;
+		item.message_id = message->messageId();
+		item.ack_id = message->header(Frame::HEADER_ACK);
+		item.done = false;
+		iter->second.messages.push_back(item);
+	}
+
+	int AckManager::ack(const Frame* message)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		std::unordered_map<std::string, Subscription>::iterator iter = subscriptions_.find(message->subscription());
+		const std::string& message_id = message->messageId();
+		std::deque<Message>::iterator found;
+
+		if (iter == subscriptions_.end())
+			return send_now(Frame::Commands::ACK, message);
+
+		std::deque<Message>& messages = iter->second.messages;
+		found = messages.end();
+		if (iter->second.mode == MODE_CLIENT) {
+			// Usually acknowledged in delivery order: the first entries are the candidates
+			for (found = messages.begin(); found != messages.end(); found++) {
+				if (!found->done && (found->message_id == message_id))
+					break;
+			}
+		}
+		if (found == messages.end()) {
+			Message item;
+			item.message_id = message_id;
+			item.ack_id = message->header(Frame::HEADER_ACK);
+			messages.push_back(item);
+			found = messages.end() - 1;
+		}
+		found->done = true;
+
+		if (!unsent_count_++)
+			unsent_since_ = std::chrono::steady_clock::now();
+		if ((unsent_count_ >= max_batch_) || (std::chrono::steady_clock::now() - unsent_since_ >= flush_interval_))
+			return flush_locked();
+		return 0;
+	}
+
+	int AckManager::nack(const Frame* message)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		std::unordered_map<std::string, Subscription>::iterator iter = subscriptions_.find(message->subscription());
+		int rc = flush_locked();
+		if ((iter != subscriptions_.end()) && (iter->second.mode == MODE_CLIENT)) {
+			// Cumulative like ACK: the NACK covers the earlier unacknowledged messages
+			std::deque<Message>& messages = iter->second.messages;
+			const std::string& message_id = message->messageId();
+			size_t i;
+			for (i = 0; i < messages.size(); i++) {
+				if (messages[i].message_id == message_id) {
+					messages.erase(messages.begin(), messages.begin() + i + 1);
+					break;
+				}
+			}
+			unsent_count_ = count_unsent();
+		}
+		if (rc)
+			return rc;
+		return send_now(Frame::Commands::NACK, message);
+	}
+
+	int AckManager::flush()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return flush_locked();
+	}
+
+	int AckManager::poll()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		if (unsent_count_ && (std::chrono::steady_clock::now() - unsent_since_ >= flush_interval_))
+			return flush_locked();
+		return 0;
+	}
+
+	size_t AckManager::unsent_count()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return unsent_count_;
+	}
+
+	Frame* AckManager::next_frame(size_t& used, const std::string& command)
+	{
+		Frame* frame;
+		if (used == frames_.size())
+			frames_.push_back(Frame());
+		frame = &frames_[used++];
+		// clear() keeps the header entries' capacity for the next flush
+		frame->clear();
+		frame->command(command);
+		return frame;
+	}
+
+	void AckManager::fill(Frame* frame, const std::string& subscription, const Message& message)
+	{
+		if (!message.ack_id.empty())
+			frame->header(Frame::HEADER_ID, message.ack_id);
+		frame->header(Frame::HEADER_MESSAGE_ID, message.message_id);
+		frame->header(Frame::HEADER_SUBSCRIPTION, subscription);
+	}
+
+	size_t AckManager::collect(const std::string& id, Subscription& subscription, size_t used)
+	{
+		std::deque<Message>& messages = subscription.messages;
+		if (subscription.mode == MODE_CLIENT) {
+			// Newest message of the acknowledged prefix
+			size_t count = 0;
+			while ((count < messages.size()) && messages[count].done)
+				count++;
+			if (count) {
+				fill(next_frame(used, Frame::Commands::ACK), id, messages[count - 1]);
+				messages.erase(messages.begin(), messages.begin() + count);
+			}
+		}
+		else {
+			for (size_t i = 0; i < messages.size(); i++)
+				fill(next_frame(used, Frame::Commands::ACK), id, messages[i]);
+			messages.clear();
+		}
+		return used;
+	}
+
+	int AckManager::flush_locked()
+	{
+		size_t used = 0;
+		size_t i;
+		if (!unsent_count_)
+			return 0;
+		for (std::unordered_map<std::string, Subscription>::iterator iter = subscriptions_.begin(); iter != subscriptions_.end(); iter++)
+			used = collect(iter->first, iter->second, used);
+		// ack:client acknowledgements behind an unacknowledged message stay
+		unsent_count_ = count_unsent();
+		if (unsent_count_)
+			unsent_since_ = std::chrono::steady_clock::now();
+		if (!used)
+			return 0;
+
+		frame_ptrs_.resize(used);
+		for (i = 0; i < used; i++)
+			frame_ptrs_[i] = &frames_[i];
+		// Sent under the lock: batches reach the client in flush order
+		return client_->sendFrames(&frame_ptrs_[0], used);
+	}
+
+	/*
+	 * @return Acknowledged messages not sent yet
+	 */
+	size_t AckManager::count_unsent() const
+	{
+		size_t count = 0;
+		for (std::unordered_map<std::string, Subscription>::const_iterator iter = subscriptions_.begin(); iter != subscriptions_.end(); iter++) {
+			const std::deque<Message>& messages = iter->second.messages;
+			for (size_t i = 0; i < messages.size(); i++) {
+				if (messages[i].done)
+					count++;
+			}
+		}
+		return count;
+	}
+
+	int AckManager::send_now(const std::string& command, const Frame* message)
+	{
+		Frame frame(command);
+		Message item;
+		item.message_id = message->messageId();
+		item.ack_id = message->header(Frame::HEADER_ACK);
+		fill(&frame, message->subscription(), item);
+		return client_->sendFrame(&frame);
+	}
+
+}
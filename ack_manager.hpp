@@ -0,0 +1,144 @@
+/**
+ * @file	ack_manager.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "frame.hpp"
+#include "client.hpp"
+#include "subscription_registry.hpp"
+#include "command/subscribe.hpp"
+
+namespace stomp {
+
+	/**
+	 * Batches the ACK frames of client / client-individual subscriptions.
+	 *
+	 * - ack:client is cumulative, so one ACK for the newest message whose
+	 *   predecessors are all acknowledged covers the whole batch.
+	 * - ack:client-individual needs one ACK per message; the batch is sent with
+	 *   Client::sendFrames as a single write.
+	 *
+	 * A batch is flushed once max_batch messages were acknowledged, or from ack()
+	 * / poll() once the oldest unsent acknowledgement is flush_interval old.
+	 * Call poll() periodically so a quiet subscription is flushed too.
+	 */
+	class AckManager {
+	public:
+		enum Mode {
+			MODE_CLIENT = 0,
+			MODE_CLIENT_INDIVIDUAL = 1,
+		};
+
+	private:
+		struct Message {
+			std::string message_id;
+			// ack header of the MESSAGE (STOMP 1.2)
+			std::string ack_id;
+			bool done;
+		};
+
+		struct Subscription {
+			Mode mode;
+			// client: delivered messages in order, client-individual: acknowledged ones
+			std::deque<Message> messages;
+		};
+
+		class TrackingHandler : public SubscriptionHandler {
+		private:
+			AckManager* manager_;
+			std::shared_ptr<SubscriptionHandler> handler_;
+			bool auto_ack_;
+
+		public:
+			TrackingHandler(AckManager* manager, const std::shared_ptr<SubscriptionHandler>& handler, bool auto_ack)
+				: manager_(manager), handler_(handler), auto_ack_(auto_ack) {}
+
+			int onMessage(Frame* frame) override;
+		};
+
+		Client* client_;
+		size_t max_batch_;
+		std::chrono::steady_clock::duration flush_interval_;
+
+		std::mutex lock_;
+		std::unordered_map<std::string, Subscription> subscriptions_;
+		// Acknowledgements since the last flush, and when the first of them came
+		size_t unsent_count_;
+		std::chrono::steady_clock::time_point unsent_since_;
+		// Reused for every flush
+		std::vector<Frame> frames_;
+		std::vector<Frame*> frame_ptrs_;
+
+		AckManager(const AckManager& o);
+		AckManager& operator=(const AckManager& o);
+
+		Frame* next_frame(size_t& used, const std::string& command);
+		static void fill(Frame* frame, const std::string& subscription, const Message& message);
+		size_t collect(const std::string& id, Subscription& subscription, size_t used);
+		int flush_locked();
+		size_t count_unsent() const;
+		int send_now(const std::string& command, const Frame* message);
+
+	public:
+		/**
+		 * @param client         Client the ACK frames are sent with
+		 * @param max_batch      Acknowledgements per flush
+		 * @param flush_interval_ms Longest an acknowledgement waits
+		 */
+		AckManager(Client* client, size_t max_batch = 64, int flush_interval_ms = 100);
+		/**
+		 * Flushes what is pending.
+		 */
+		~AckManager();
+
+		static const char* mode_name(Mode mode);
+
+		/**
+		 * Sets the ack mode of subscribe, tracks its subscription and binds
+		 * handler. Every delivered MESSAGE is recorded first; with auto_ack it is
+		 * acknowledged when handler returns 0 and NACKed otherwise.
+		 */
+		command::Subscribe::Handle bind(command::Subscribe& subscribe, Mode mode, const std::shared_ptr<SubscriptionHandler>& handler, bool auto_ack = true);
+
+		void track(const std::string& subscription, Mode mode);
+		/**
+		 * Flushes and forgets subscription (after UNSUBSCRIBE).
+		 */
+		void untrack(const std::string& subscription);
+
+		/**
+		 * Records a MESSAGE as delivered (ack:client ordering).
+		 */
+		void delivered(const Frame* message);
+		/**
+		 * Acknowledges a MESSAGE; sent now if its subscription is not tracked.
+		 */
+		int ack(const Frame* message);
+		/**
+		 * Flushes the pending ACK frames, then sends a NACK for message.
+		 */
+		int nack(const Frame* message);
+
+		int flush();
+		/**
+		 * Flushes if the oldest unsent acknowledgement is due.
+		 */
+		int poll();
+
+		size_t unsent_count();
+	};
+
+}
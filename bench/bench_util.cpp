@@ -0,0 +1,138 @@
+/**
+ * @file	bench_util.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "bench_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+	std::atomic<uint64_t> g_allocations(0);
+}
+
+void* operator new(size_t size) {
+	void* ptr;
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+namespace stomp {
+
+	namespace bench {
+
+		uint64_t allocation_count() {
+			return g_allocations.load(std::memory_order_relaxed);
+		}
+
+		bool read_file(const std::string& path, std::string& out) {
+			FILE* fp = fopen(path.c_str(), "rb");
+			char buf[16384];
+			size_t n;
+			if (!fp)
+				return false;
+			out.clear();
+			while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+				out.append(buf, n);
+			fclose(fp);
+			return true;
+		}
+
+#if defined(__GNUC__) || defined(__clang__)
+		void do_not_optimize(const void* ptr) {
+			// Tells the compiler ptr and all memory are read here
+			asm volatile("" : : "g"(ptr) : "memory");
+		}
+#else
+		const void* volatile do_not_optimize_sink;
+
+		void do_not_optimize(const void* ptr) {
+			do_not_optimize_sink = ptr;
+		}
+#endif
+
+		Runner::Runner(double min_seconds)
+			: min_seconds_(min_seconds)
+		{}
+
+		void Runner::set_filter(const std::string& filter) {
+			filter_ = filter;
+		}
+
+		void Runner::set_min_seconds(double seconds) {
+			min_seconds_ = seconds;
+		}
+
+		void Runner::print_header() {
+			printf("%-44s %12s %14s %12s %12s\n", "case", "ns/frame", "frames/s", "MB/s", "allocs/frame");
+		}
+
+		bool Runner::run(const std::string& name, Function func, void* context) {
+			typedef std::chrono::steady_clock clock;
+			Result total = { 0, 0 };
+			uint64_t allocations;
+			double seconds;
+			clock::time_point start;
+
+			if (!filter_.empty() && (name.find(filter_) == std::string::npos))
+				return false;
+
+			// Warm-up run fills caches and pools
+			func(context);
+
+			allocations = allocation_count();
+			start = clock::now();
+			do {
+				Result result = func(context);
+				total.frames += result.frames;
+				total.bytes += result.bytes;
+				seconds = std::chrono::duration<double>(clock::now() - start).count();
+			} while (seconds < min_seconds_);
+			allocations = allocation_count() - allocations;
+
+			if (total.frames == 0)
+				total.frames = 1;
+			printf("%-44s %12.1f %14.0f %12.1f %12.2f\n",
+				name.c_str(),
+				seconds * 1e9 / (double)total.frames,
+				(double)total.frames / seconds,
+				(double)total.bytes / seconds / (1024.0 * 1024.0),
+				(double)allocations / (double)total.frames);
+			fflush(stdout);
+			return true;
+		}
+
+	}
+
+}
@@ -0,0 +1,75 @@
+/**
+ * @file	bench_util.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace stomp {
+
+	namespace bench {
+
+		/**
+		 * Number of global operator new calls so far (counted by bench_util.cpp).
+		 */
+		uint64_t allocation_count();
+
+		bool read_file(const std::string& path, std::string& out);
+
+		/**
+		 * Times a case and prints one result line.
+		 * The body runs repeatedly until min_seconds have passed; each run
+		 * reports how many frames and bytes it processed.
+		 */
+		class Runner {
+		public:
+			struct Result {
+				uint64_t frames;
+				uint64_t bytes;
+			};
+
+			typedef Result (*Function)(void* context);
+
+		private:
+			double min_seconds_;
+			std::string filter_;
+
+		public:
+			Runner(double min_seconds = 0.5);
+
+			void set_filter(const std::string& filter);
+			void set_min_seconds(double seconds);
+
+			bool run(const std::string& name, Function func, void* context);
+
+			template<typename T>
+			bool run(const std::string& name, T& callable) {
+				return run(name, &invoke<T>, &callable);
+			}
+
+			static void print_header();
+
+		private:
+			template<typename T>
+			static Result invoke(void* context) {
+				return (*static_cast<T*>(context))();
+			}
+		};
+
+		/**
+		 * Keeps the compiler from dropping a computed value.
+		 */
+		void do_not_optimize(const void* ptr);
+
+	}
+
+}
@@ -0,0 +1,404 @@
+/**
+ * @file	frame_bench.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ *
+ * Frame / FrameReader benchmark over the frames in bench/corpus.
+ *
+ * usage: stomp_frame_bench [--corpus DIR] [--filter TEXT] [--min-time SECONDS] [--isa generic|sse2|avx2]
+ */
+#include "bench_util.hpp"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame.hpp"
+#include "frame_reader.hpp"
+#include "frame_pool.hpp"
+#include "scanner.hpp"
+
+#ifndef STOMP_BENCH_CORPUS_DIR
+#define STOMP_BENCH_CORPUS_DIR "corpus"
+#endif
+
+using namespace stomp;
+
+namespace {
+
+	const char* const corpus_names[] = {
+		"small_json",
+		"escaped_headers",
+		"heartbeats",
+		"large_binary"
+	};
+
+	struct Corpus {
+		std::string name;
+		std::string data;
+		std::vector< std::unique_ptr<Frame> > frames;
+	};
+
+	class CountingHandler : public FrameHandler {
+	public:
+		uint64_t frames;
+
+		CountingHandler() : frames(0) {}
+
+		int onFrame(Frame* frame) override {
+			bench::do_not_optimize(frame);
+			frames++;
+			return 0;
+		}
+
+		int onFrameView(const FrameView& view) override {
+			bench::do_not_optimize(&view);
+			frames++;
+			return 0;
+		}
+	};
+
+	/**
+	 * Feeds the corpus to a FrameReader in chunk_size pieces, like a socket would.
+	 */
+	struct DecodeCase {
+		const Corpus* corpus;
+		int chunk_size;
+		FramePool pool;
+		FrameReader reader;
+		CountingHandler handler;
+
+		DecodeCase(const Corpus* c, int size)
+			: corpus(c), chunk_size(size)
+		{
+			reader.set_frame_pool(&pool);
+		}
+
+		bench::Runner::Result operator()() {
+			const char* data = corpus->data.data();
+			int remaining = (int)corpus->data.size();
+			bench::Runner::Result result;
+			handler.frames = 0;
+			while (remaining > 0) {
+				int length = (remaining < chunk_size) ? remaining : chunk_size;
+				reader.decode(data, length, &handler);
+				data += length;
+				remaining -= length;
+			}
+			result.frames = handler.frames;
+			result.bytes = corpus->data.size();
+			return result;
+		}
+	};
+
+	struct PayloadCase {
+		const Corpus* corpus;
+		std::vector<char> output;
+
+		PayloadCase(const Corpus* c) : corpus(c) {}
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result = { 0, 0 };
+			for (size_t i = 0; i < corpus->frames.size(); i++) {
+				output.clear();
+				corpus->frames[i]->make_payload_append(output);
+				bench::do_not_optimize(output.data());
+				result.bytes += output.size();
+			}
+			result.frames = corpus->frames.size();
+			return result;
+		}
+	};
+
+	/**
+	 * Header values of every corpus frame, raw and escaped.
+	 */
+	struct HeaderValues {
+		std::vector<std::string> raw;
+		std::vector<std::string> encoded;
+		uint64_t frames;
+		uint64_t raw_bytes;
+		uint64_t encoded_bytes;
+
+		HeaderValues(const Corpus* corpus)
+			: frames(corpus->frames.size()), raw_bytes(0), encoded_bytes(0)
+		{
+			for (size_t i = 0; i < corpus->frames.size(); i++) {
+				const Frame& frame = *corpus->frames[i];
+				for (size_t j = 0; j < frame.header_count(); j++) {
+					const std::string& value = frame.header_at(j).value;
+					raw.push_back(value);
+					encoded.push_back(Frame::header_encode(value));
+					raw_bytes += value.size();
+					encoded_bytes += encoded.back().size();
+				}
+			}
+		}
+	};
+
+	struct HeaderEncodeCase {
+		HeaderValues values;
+		std::vector<char> output;
+
+		HeaderEncodeCase(const Corpus* c) : values(c) {}
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result = { values.frames, values.raw_bytes };
+			for (size_t i = 0; i < values.raw.size(); i++) {
+				output.clear();
+				Frame::header_encode_append(values.raw[i].data(), values.raw[i].size(), output);
+				bench::do_not_optimize(output.data());
+			}
+			return result;
+		}
+	};
+
+	struct HeaderDecodeCase {
+		HeaderValues values;
+		std::vector<char> buffer;
+
+		HeaderDecodeCase(const Corpus* c) : values(c) {}
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result = { values.frames, values.encoded_bytes };
+			for (size_t i = 0; i < values.encoded.size(); i++) {
+				const std::string& encoded = values.encoded[i];
+				size_t length;
+				buffer.assign(encoded.begin(), encoded.end());
+				if (buffer.empty())
+					continue;
+				length = Frame::header_decode_inplace(&buffer[0], buffer.size());
+				bench::do_not_optimize(&length);
+			}
+			return result;
+		}
+	};
+
+	struct HeaderStringCase {
+		HeaderValues values;
+		bool encode;
+
+		HeaderStringCase(const Corpus* c, bool is_encode) : values(c), encode(is_encode) {}
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result = { values.frames, encode ? values.raw_bytes : values.encoded_bytes };
+			const std::vector<std::string>& input = encode ? values.raw : values.encoded;
+			for (size_t i = 0; i < input.size(); i++) {
+				std::string output = encode ? Frame::header_encode(input[i]) : Frame::header_decode(input[i]);
+				bench::do_not_optimize(output.data());
+			}
+			return result;
+		}
+	};
+
+	struct Utf8Case {
+		const Corpus* corpus;
+		uint64_t bytes;
+
+		Utf8Case(const Corpus* c) : corpus(c), bytes(0) {
+			for (size_t i = 0; i < corpus->frames.size(); i++)
+				bytes += corpus->frames[i]->body().size();
+		}
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result = { corpus->frames.size(), bytes };
+			uint64_t characters = 0;
+			for (size_t i = 0; i < corpus->frames.size(); i++) {
+				const std::string& body = corpus->frames[i]->body();
+				const char* ptr = body.data();
+				int remaining = (int)body.size();
+				while (remaining > 0) {
+					int n = Frame::utf8_bytes(ptr, remaining);
+					if (n <= 0)
+						n = 1;
+					ptr += n;
+					remaining -= n;
+					characters++;
+				}
+			}
+			bench::do_not_optimize(&characters);
+			return result;
+		}
+	};
+
+	/**
+	 * Walks the whole corpus with find_byte for a rare byte, the same access
+	 * pattern as the NUL / newline searches in FrameReader. With byte_loop set
+	 * it runs the per-character loop FrameReader used before the scanner.
+	 */
+	struct ScanCase {
+		const Corpus* corpus;
+		bool byte_loop;
+
+		ScanCase(const Corpus* c, bool loop = false) : corpus(c), byte_loop(loop) {}
+
+		bench::Runner::Result operator()() {
+			const char* begin = corpus->data.data();
+			const char* end = begin + corpus->data.size();
+			bench::Runner::Result result = { corpus->frames.size(), corpus->data.size() };
+			const char* found = begin;
+			if (byte_loop) {
+				for (;;) {
+					while ((found < end) && (*found != '\x01'))
+						found++;
+					if (found == end)
+						break;
+					found++;
+				}
+			}
+			else {
+				while ((found = Scanner::find_byte(found, end, '\x01')) != end)
+					found++;
+			}
+			bench::do_not_optimize(found);
+			return result;
+		}
+	};
+
+	/**
+	 * Walks the whole corpus with find_header_escape, as header encoding does.
+	 */
+	struct EscapeScanCase {
+		const Corpus* corpus;
+
+		EscapeScanCase(const Corpus* c) : corpus(c) {}
+
+		bench::Runner::Result operator()() {
+			const char* begin = corpus->data.data();
+			const char* end = begin + corpus->data.size();
+			bench::Runner::Result result = { corpus->frames.size(), corpus->data.size() };
+			const char* found = begin;
+			while ((found = Scanner::find_header_escape(found, end)) != end)
+				found++;
+			bench::do_not_optimize(found);
+			return result;
+		}
+	};
+
+	bool load_corpus(const std::string& dir, Corpus& corpus) {
+		std::list< std::unique_ptr<Frame> > frames;
+		FrameReader reader;
+		if (!bench::read_file(dir + "/" + corpus.name + ".stomp", corpus.data)) {
+			fprintf(stderr, "cannot read %s/%s.stomp\n", dir.c_str(), corpus.name.c_str());
+			return false;
+		}
+		reader.decode(corpus.data.data(), (int)corpus.data.size(), frames);
+		for (std::list< std::unique_ptr<Frame> >::iterator iter = frames.begin(); iter != frames.end(); iter++)
+			corpus.frames.emplace_back(std::move(*iter));
+		return true;
+	}
+
+	std::string chunk_label(int chunk_size) {
+		char buf[32];
+		if (chunk_size == 0x7fffffff)
+			return "whole";
+		snprintf(buf, sizeof(buf), "%d", chunk_size);
+		return buf;
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	static const int chunk_sizes[] = { 0x7fffffff, 16384, 1460, 64, 7 };
+	std::string corpus_dir = STOMP_BENCH_CORPUS_DIR;
+	std::vector< std::unique_ptr<Corpus> > corpora;
+	bench::Runner runner;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--corpus") && (i + 1 < argc)) {
+			corpus_dir = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--filter") && (i + 1 < argc)) {
+			runner.set_filter(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--isa") && (i + 1 < argc)) {
+			const char* name = argv[++i];
+			int isa;
+			for (isa = Scanner::ISA_GENERIC; isa <= Scanner::ISA_AVX2; isa++) {
+				if (!strcmp(name, Scanner::isa_name((Scanner::Isa)isa)))
+					break;
+			}
+			if ((isa > Scanner::ISA_AVX2) || !Scanner::select_isa((Scanner::Isa)isa)) {
+				fprintf(stderr, "isa %s is not supported\n", name);
+				return 2;
+			}
+		}
+		else if (!strcmp(argv[i], "--min-time") && (i + 1 < argc)) {
+			runner.set_min_seconds(atof(argv[++i]));
+		}
+		else {
+			fprintf(stderr, "usage: %s [--corpus DIR] [--filter TEXT] [--min-time SECONDS] [--isa generic|sse2|avx2]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	for (i = 0; i < (int)(sizeof(corpus_names) / sizeof(corpus_names[0])); i++) {
+		std::unique_ptr<Corpus> corpus(new Corpus());
+		corpus->name = corpus_names[i];
+		if (!load_corpus(corpus_dir, *corpus))
+			return 1;
+		corpora.emplace_back(std::move(corpus));
+	}
+
+	bench::Runner::print_header();
+
+	for (i = 0; i < (int)corpora.size(); i++) {
+		const Corpus* corpus = corpora[i].get();
+		for (size_t j = 0; j < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); j++) {
+			DecodeCase decode_case(corpus, chunk_sizes[j]);
+			runner.run("decode/" + corpus->name + "/chunk:" + chunk_label(chunk_sizes[j]), decode_case);
+		}
+	}
+
+	for (i = 0; i < (int)corpora.size(); i++) {
+		const Corpus* corpus = corpora[i].get();
+		PayloadCase payload_case(corpus);
+		HeaderEncodeCase encode_case(corpus);
+		HeaderDecodeCase decode_case(corpus);
+		HeaderStringCase encode_string_case(corpus, true);
+		HeaderStringCase decode_string_case(corpus, false);
+		Utf8Case utf8_case(corpus);
+		if (corpus->frames.empty())
+			continue;
+		runner.run("make_payload_append/" + corpus->name, payload_case);
+		runner.run("header_encode_append/" + corpus->name, encode_case);
+		runner.run("header_decode_inplace/" + corpus->name, decode_case);
+		runner.run("header_encode/" + corpus->name, encode_string_case);
+		runner.run("header_decode/" + corpus->name, decode_string_case);
+		runner.run("utf8_bytes/" + corpus->name, utf8_case);
+	}
+
+	for (size_t j = 0; j < corpora.size(); j++) {
+		ScanCase loop_case(corpora[j].get(), true);
+		runner.run("find_byte/byte_loop/" + corpora[j]->name, loop_case);
+	}
+	for (i = Scanner::ISA_GENERIC; i <= Scanner::ISA_AVX2; i++) {
+		Scanner::Isa isa = (Scanner::Isa)i;
+		if (!Scanner::select_isa(isa))
+			continue;
+		for (size_t j = 0; j < corpora.size(); j++) {
+			ScanCase scan_case(corpora[j].get());
+			runner.run(std::string("find_byte/") + Scanner::isa_name(isa) + "/" + corpora[j]->name, scan_case);
+		}
+	}
+	for (i = Scanner::ISA_GENERIC; i <= Scanner::ISA_AVX2; i++) {
+		Scanner::Isa isa = (Scanner::Isa)i;
+		if (!Scanner::select_isa(isa))
+			continue;
+		for (size_t j = 0; j < corpora.size(); j++) {
+			EscapeScanCase scan_case(corpora[j].get());
+			runner.run(std::string("find_header_escape/") + Scanner::isa_name(isa) + "/" + corpora[j]->name, scan_case);
+		}
+	}
+
+	return 0;
+}
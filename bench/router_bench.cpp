@@ -0,0 +1,298 @@
+/**
+ * @file	router_bench.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ *
+ * DestinationRouter fan-out against a linear scan over every pattern.
+ * Pattern sets mix exact destinations, "*" and ">" / "#" wildcards.
+ *
+ * usage: stomp_router_bench [--filter TEXT] [--min-time SECONDS] [--patterns N]
+ */
+#include "bench_util.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame.hpp"
+#include "destination_router.hpp"
+
+using namespace stomp;
+
+namespace {
+
+	const int market_count = 16;
+
+	class CountingHandler : public SubscriptionHandler {
+	public:
+		uint64_t calls;
+
+		CountingHandler() : calls(0) {}
+
+		int onMessage(Frame* frame) override {
+			calls++;
+			return 0;
+		}
+	};
+
+	std::string market_name(int index) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "m%02d", index);
+		return buf;
+	}
+
+	std::string symbol_name(int index) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "S%05d", index);
+		return buf;
+	}
+
+	/**
+	 * 70% "/topic/prices.<market>.<symbol>", 20% "/topic/prices.*.<symbol>",
+	 * 10% "/topic/prices.<market>.<symbol>.>" / "/topic/news.<n>.#".
+	 */
+	void make_patterns(int count, std::vector<std::string>& patterns) {
+		int i;
+		for (i = 0; i < count; i++) {
+			int kind = i % 10;
+			if (kind < 7) {
+				patterns.push_back("/topic/prices." + market_name(i % market_count) + "." + symbol_name(i));
+			}
+			else if (kind < 9) {
+				patterns.push_back("/topic/prices.*." + symbol_name(i - kind));
+			}
+			else if ((i / 10) % 2) {
+				patterns.push_back("/topic/prices." + market_name(i % market_count) + "." + symbol_name(i - kind) + ".>");
+			}
+			else {
+				char buf[32];
+				snprintf(buf, sizeof(buf), "/topic/news.n%d.#", i);
+				patterns.push_back(buf);
+			}
+		}
+	}
+
+	void make_destinations(int pattern_count, std::vector<std::string>& destinations) {
+		int i;
+		srand(7);
+		for (i = 0; i < 4096; i++) {
+			int symbol = rand() % pattern_count;
+			int market = symbol % market_count;
+			switch (i % 4) {
+			case 0:
+			case 1:
+				destinations.push_back("/topic/prices." + market_name(market) + "." + symbol_name(symbol));
+				break;
+			case 2:
+				destinations.push_back("/topic/prices." + market_name(market) + "." + symbol_name(symbol - symbol % 10) + ".bid");
+				break;
+			default:
+				{
+					char buf[48];
+					snprintf(buf, sizeof(buf), "/topic/news.n%d.eu.%d", symbol - symbol % 10 + 9, i);
+					destinations.push_back(buf);
+				}
+				break;
+			}
+		}
+	}
+
+	std::vector<std::string> split(const std::string& text) {
+		std::vector<std::string> segments;
+		size_t begin = 0;
+		size_t i;
+		for (i = 0; i < text.size(); i++) {
+			if ((text[i] == '/') || (text[i] == '.')) {
+				segments.push_back(text.substr(begin, i - begin));
+				begin = i + 1;
+			}
+		}
+		segments.push_back(text.substr(begin));
+		return segments;
+	}
+
+	/**
+	 * What applications do without a router: test every pattern per message.
+	 */
+	class LinearRouter {
+	private:
+		struct Entry {
+			std::vector<std::string> segments;
+			std::shared_ptr<SubscriptionHandler> handler;
+		};
+		std::vector<Entry> entries_;
+
+		static bool matches(const std::vector<std::string>& pattern, const std::vector<std::string>& destination) {
+			size_t i;
+			for (i = 0; i < pattern.size(); i++) {
+				const std::string& segment = pattern[i];
+				if ((i + 1 == pattern.size()) && (segment == "#"))
+					return true;
+				if ((i + 1 == pattern.size()) && (segment == ">"))
+					return destination.size() > i;
+				if (i >= destination.size())
+					return false;
+				if ((segment != "*") && (segment != destination[i]))
+					return false;
+			}
+			return pattern.size() == destination.size();
+		}
+
+	public:
+		void add(const std::string& pattern, const std::shared_ptr<SubscriptionHandler>& handler) {
+			Entry entry;
+			entry.segments = split(pattern);
+			entry.handler = handler;
+			entries_.push_back(entry);
+		}
+
+		int onMessage(Frame* frame) {
+			std::vector<std::string> destination = split(frame->destination());
+			for (size_t i = 0; i < entries_.size(); i++) {
+				if (matches(entries_[i].segments, destination))
+					entries_[i].handler->onMessage(frame);
+			}
+			return 0;
+		}
+	};
+
+	template<typename Router>
+	struct DispatchCase {
+		Router& router;
+		std::vector<Frame>& frames;
+		size_t next;
+
+		DispatchCase(Router& r, std::vector<Frame>& f)
+			: router(r), frames(f), next(0) {}
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result;
+			result.frames = 0;
+			result.bytes = 0;
+			for (int i = 0; i < 1024; i++) {
+				Frame& frame = frames[next];
+				next = (next + 1) % frames.size();
+				router.onMessage(&frame);
+				result.frames++;
+				result.bytes += frame.destination().size();
+			}
+			return result;
+		}
+	};
+
+	uint64_t total_calls(const std::vector<std::shared_ptr<CountingHandler> >& handlers) {
+		uint64_t total = 0;
+		for (size_t i = 0; i < handlers.size(); i++)
+			total += handlers[i]->calls;
+		return total;
+	}
+
+	/**
+	 * Both routers must deliver the same messages to the same handlers.
+	 */
+	bool verify(const std::vector<std::string>& patterns, std::vector<Frame>& frames) {
+		std::vector<std::shared_ptr<CountingHandler> > trie_handlers;
+		std::vector<std::shared_ptr<CountingHandler> > linear_handlers;
+		DestinationRouter trie;
+		LinearRouter linear;
+		size_t i;
+		for (i = 0; i < patterns.size(); i++) {
+			trie_handlers.push_back(std::make_shared<CountingHandler>());
+			linear_handlers.push_back(std::make_shared<CountingHandler>());
+			trie.add(patterns[i], trie_handlers.back());
+			linear.add(patterns[i], linear_handlers.back());
+		}
+		for (i = 0; i < frames.size(); i++) {
+			trie.onMessage(&frames[i]);
+			linear.onMessage(&frames[i]);
+		}
+		for (i = 0; i < patterns.size(); i++) {
+			if (trie_handlers[i]->calls != linear_handlers[i]->calls) {
+				fprintf(stderr, "pattern %s: trie %llu, linear %llu\n", patterns[i].c_str(),
+					(unsigned long long)trie_handlers[i]->calls, (unsigned long long)linear_handlers[i]->calls);
+				return false;
+			}
+		}
+		printf("# %zu patterns, %zu destinations, %llu deliveries\n", patterns.size(), frames.size(), (unsigned long long)total_calls(trie_handlers));
+		return true;
+	}
+
+	bool run_pattern_count(bench::Runner& runner, int pattern_count) {
+		std::vector<std::string> patterns;
+		std::vector<std::string> destinations;
+		std::vector<Frame> frames;
+		std::vector<std::shared_ptr<CountingHandler> > handlers;
+		DestinationRouter trie;
+		LinearRouter linear;
+		char label[64];
+		size_t i;
+
+		make_patterns(pattern_count, patterns);
+		make_destinations(pattern_count, destinations);
+		frames.resize(destinations.size());
+		for (i = 0; i < destinations.size(); i++) {
+			frames[i].command(Frame::Commands::MESSAGE);
+			frames[i].header(Frame::HEADER_DESTINATION, destinations[i]);
+		}
+		if (!verify(patterns, frames))
+			return false;
+
+		for (i = 0; i < patterns.size(); i++) {
+			handlers.push_back(std::make_shared<CountingHandler>());
+			trie.add(patterns[i], handlers.back());
+			linear.add(patterns[i], handlers.back());
+		}
+
+		{
+			DispatchCase<DestinationRouter> test_case(trie, frames);
+			snprintf(label, sizeof(label), "trie/patterns:%d", pattern_count);
+			runner.run(label, test_case);
+		}
+		{
+			DispatchCase<LinearRouter> test_case(linear, frames);
+			snprintf(label, sizeof(label), "linear/patterns:%d", pattern_count);
+			runner.run(label, test_case);
+		}
+		return true;
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	bench::Runner runner;
+	int pattern_counts[] = { 100, 1000, 10000 };
+	int count = 3;
+	bool ok = true;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--filter") && (i + 1 < argc)) {
+			runner.set_filter(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--min-time") && (i + 1 < argc)) {
+			runner.set_min_seconds(atof(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--patterns") && (i + 1 < argc)) {
+			pattern_counts[0] = atoi(argv[++i]);
+			count = 1;
+		}
+		else {
+			fprintf(stderr, "usage: %s [--filter TEXT] [--min-time SECONDS] [--patterns N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	bench::Runner::print_header();
+
+	for (i = 0; i < count; i++)
+		ok = run_pattern_count(runner, pattern_counts[i]) && ok;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file	send_queue_bench.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ *
+ * Send queue contention: N producer threads, one consumer thread, as in
+ * LibwebsocketsClient (publishers vs. the lws service thread).
+ * Compares MpscQueue with the mutex + std::deque queue it replaced.
+ *
+ * usage: stomp_send_queue_bench [--filter TEXT] [--min-time SECONDS] [--messages N]
+ */
+#include "bench_util.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpsc_queue.hpp"
+
+using namespace stomp;
+
+namespace {
+
+	struct Message : public MpscNode {
+		int producer;
+		int sequence;
+	};
+
+	class MpscSendQueue {
+	private:
+		MpscQueue<Message> queue_;
+
+	public:
+		void push(Message* item) {
+			queue_.push(item);
+		}
+
+		Message* pop() {
+			return queue_.pop();
+		}
+	};
+
+	class LockedSendQueue {
+	private:
+		std::mutex lock_;
+		std::deque<Message*> queue_;
+
+	public:
+		void push(Message* item) {
+			std::unique_lock<std::mutex> lock(lock_);
+			queue_.push_back(item);
+		}
+
+		Message* pop() {
+			std::unique_lock<std::mutex> lock(lock_);
+			Message* item;
+			if (queue_.empty())
+				return NULL;
+			item = queue_.front();
+			queue_.pop_front();
+			return item;
+		}
+	};
+
+	template<typename Queue>
+	struct ContentionCase {
+		int producers;
+		int messages_per_producer;
+		std::vector<Message> messages;
+		bool ordered;
+
+		ContentionCase(int producer_count, int total_messages)
+			: producers(producer_count),
+			messages_per_producer(total_messages / producer_count),
+			messages((size_t)producer_count * (total_messages / producer_count)),
+			ordered(true)
+		{}
+
+		bench::Runner::Result operator()() {
+			Queue queue;
+			std::atomic<int> ready(0);
+			std::vector<std::thread> threads;
+			std::vector<int> next_sequence(producers, 0);
+			bench::Runner::Result result;
+			size_t total = messages.size();
+			size_t received = 0;
+			int i;
+
+			for (i = 0; i < producers; i++) {
+				threads.push_back(std::thread([this, &queue, &ready, i]() {
+					Message* base = &messages[(size_t)i * messages_per_producer];
+					int n;
+					ready.fetch_add(1);
+					while (ready.load() < producers)
+						std::this_thread::yield();
+					for (n = 0; n < messages_per_producer; n++) {
+						base[n].producer = i;
+						base[n].sequence = n;
+						queue.push(&base[n]);
+					}
+				}));
+			}
+
+			while (received < total) {
+				Message* item = queue.pop();
+				if (!item) {
+					std::this_thread::yield();
+					continue;
+				}
+				// Per-producer FIFO order must hold
+				if (item->sequence != next_sequence[item->producer])
+					ordered = false;
+				next_sequence[item->producer] = item->sequence + 1;
+				received++;
+			}
+
+			for (i = 0; i < producers; i++)
+				threads[i].join();
+
+			result.frames = total;
+			result.bytes = 0;
+			return result;
+		}
+	};
+
+	template<typename Queue>
+	bool run_case(bench::Runner& runner, const char* name, int producers, int messages) {
+		char label[64];
+		ContentionCase<Queue> test_case(producers, messages);
+		snprintf(label, sizeof(label), "%s/producers:%d", name, producers);
+		runner.run(label, test_case);
+		if (!test_case.ordered) {
+			fprintf(stderr, "%s: per-producer order violated\n", label);
+			return false;
+		}
+		return true;
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	static const int producer_counts[] = { 1, 2, 4, 8, 16 };
+	bench::Runner runner;
+	int messages = 1 << 20;
+	bool ok = true;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--filter") && (i + 1 < argc)) {
+			runner.set_filter(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--min-time") && (i + 1 < argc)) {
+			runner.set_min_seconds(atof(argv[++i]));
+		}
+		else if (!strcmp(argv[i], "--messages") && (i + 1 < argc)) {
+			messages = atoi(argv[++i]);
+		}
+		else {
+			fprintf(stderr, "usage: %s [--filter TEXT] [--min-time SECONDS] [--messages N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	bench::Runner::print_header();
+
+	for (i = 0; i < (int)(sizeof(producer_counts) / sizeof(producer_counts[0])); i++) {
+		ok = run_case<MpscSendQueue>(runner, "mpsc_queue", producer_counts[i], messages) && ok;
+		ok = run_case<LockedSendQueue>(runner, "mutex_deque", producer_counts[i], messages) && ok;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,362 @@
+/**
+ * @file	tcp_bench.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ *
+ * TcpClient against a stand-in broker on the loopback interface: CONNECT /
+ * CONNECTED, RECEIPT for receipt headers, and MESSAGE echoes of SEND frames
+ * to subscribed destinations.
+ *
+ * usage: stomp_tcp_bench [--filter TEXT] [--min-time SECONDS] [--messages N]
+ */
+#include "bench_util.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "frame.hpp"
+#include "frame_reader.hpp"
+#include "tcp_client.hpp"
+#include "command/send.hpp"
+#include "command/subscribe.hpp"
+
+using namespace stomp;
+
+namespace {
+
+	/**
+	 * One connection at a time, blocking sockets, replies written in place.
+	 */
+	class StandInBroker : public FrameHandler {
+	private:
+		int listen_fd_;
+		int port_;
+		int fd_;
+		std::thread thread_;
+		std::map<std::string, std::string> subscriptions_;
+		uint64_t message_id_;
+		std::vector<char> reply_;
+
+		void reply(Frame& frame) {
+			reply_.clear();
+			frame.make_payload_append(reply_);
+			for (size_t offset = 0; offset < reply_.size(); ) {
+				ssize_t rc = write(fd_, &reply_[offset], reply_.size() - offset);
+				if (rc <= 0)
+					return;
+				offset += (size_t)rc;
+			}
+		}
+
+		void run() {
+			std::vector<char> buffer(65536);
+			for (;;) {
+				FrameReader reader;
+				fd_ = accept(listen_fd_, NULL, NULL);
+				if (fd_ < 0)
+					return;
+				subscriptions_.clear();
+				for (;;) {
+					ssize_t length = read(fd_, &buffer[0], buffer.size());
+					if ((length <= 0) || (reader.decode(&buffer[0], (int)length, this) < 0))
+						break;
+				}
+				::close(fd_);
+			}
+		}
+
+	public:
+		std::atomic<uint64_t> sends;
+		std::atomic<uint64_t> send_bytes;
+
+		StandInBroker()
+			: listen_fd_(-1), port_(0), fd_(-1), message_id_(0), sends(0), send_bytes(0) {}
+
+		~StandInBroker() {
+			if (listen_fd_ >= 0) {
+				shutdown(listen_fd_, SHUT_RDWR);
+				::close(listen_fd_);
+			}
+			if (thread_.joinable())
+				thread_.join();
+		}
+
+		bool start() {
+			struct sockaddr_in address;
+			socklen_t length = sizeof(address);
+			listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if ((listen_fd_ < 0)
+				|| bind(listen_fd_, (struct sockaddr*)&address, sizeof(address))
+				|| listen(listen_fd_, 4)
+				|| getsockname(listen_fd_, (struct sockaddr*)&address, &length))
+				return false;
+			port_ = ntohs(address.sin_port);
+			thread_ = std::thread(&StandInBroker::run, this);
+			return true;
+		}
+
+		int port() const {
+			return port_;
+		}
+
+		int onFrame(Frame* frame) override {
+			Frame out;
+			switch (frame->command_id()) {
+			case Frame::COMMAND_CONNECT:
+			case Frame::COMMAND_STOMP:
+				out.command(Frame::Commands::CONNECTED);
+				out.header(Frame::HEADER_VERSION, "1.1");
+				out.header(Frame::HEADER_HEART_BEAT, "0,0");
+				reply(out);
+				break;
+			case Frame::COMMAND_SUBSCRIBE:
+				subscriptions_[frame->destination()] = frame->header(Frame::HEADER_ID);
+				break;
+			case Frame::COMMAND_SEND: {
+				std::map<std::string, std::string>::iterator iter = subscriptions_.find(frame->destination());
+				sends.fetch_add(1);
+				send_bytes.fetch_add(frame->body().size());
+				if (iter != subscriptions_.end()) {
+					char id[32];
+					snprintf(id, sizeof(id), "m-%llu", (unsigned long long)++message_id_);
+					out.command(Frame::Commands::MESSAGE);
+					out.header(Frame::HEADER_SUBSCRIPTION, iter->second);
+					out.header(Frame::HEADER_MESSAGE_ID, id);
+					out.header(Frame::HEADER_DESTINATION, frame->destination());
+					out.body(frame->body());
+					reply(out);
+					out.clear();
+				}
+				break;
+			}
+			default:
+				break;
+			}
+			if (frame->has_header(Frame::HEADER_RECEIPT)) {
+				out.command(Frame::Commands::RECEIPT);
+				out.header(Frame::HEADER_RECEIPT_ID, frame->header(Frame::HEADER_RECEIPT));
+				reply(out);
+			}
+			return 0;
+		}
+	};
+
+	class BenchClient : public TcpClient {
+	private:
+		std::mutex lock_;
+		std::condition_variable cond_;
+		bool connected_;
+		uint64_t messages_;
+		std::thread thread_;
+
+	public:
+		BenchClient()
+			: connected_(false), messages_(0) {}
+
+		~BenchClient() {
+			stop();
+			if (thread_.joinable())
+				thread_.join();
+		}
+
+		bool start(int port) {
+			std::unique_lock<std::mutex> lock(lock_);
+			if (connect("127.0.0.1", port))
+				return false;
+			thread_ = std::thread(&BenchClient::run, this);
+			return cond_.wait_for(lock, std::chrono::seconds(5), [this]() { return connected_; });
+		}
+
+		int onConnected(Frame* frame) override {
+			std::unique_lock<std::mutex> lock(lock_);
+			connected_ = true;
+			cond_.notify_all();
+			return 0;
+		}
+
+		int onMessage(Frame* frame) override {
+			std::unique_lock<std::mutex> lock(lock_);
+			messages_++;
+			cond_.notify_all();
+			return 0;
+		}
+
+		bool wait_messages(uint64_t count) {
+			std::unique_lock<std::mutex> lock(lock_);
+			return cond_.wait_for(lock, std::chrono::seconds(10), [this, count]() { return messages_ >= count; });
+		}
+
+		uint64_t messages() {
+			std::unique_lock<std::mutex> lock(lock_);
+			return messages_;
+		}
+	};
+
+	/**
+	 * messages SEND frames, the last with a receipt that is waited for.
+	 */
+	struct SendCase {
+		BenchClient* client;
+		std::string body;
+		int messages;
+		int batch;
+		bool ok;
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result;
+			std::vector<Frame> frames(batch);
+			std::vector<Frame*> frame_ptrs(batch);
+			int sent = 0;
+			int i;
+
+			for (i = 0; i < batch; i++) {
+				command::Send send(client);
+				send.destination("/queue/bench").body(body);
+				frames[i].swap(*send.frame());
+				frame_ptrs[i] = &frames[i];
+			}
+			while (sent + batch < messages) {
+				if (((batch == 1) ? client->sendFrame(frame_ptrs[0]) : client->sendFrames(&frame_ptrs[0], batch)) != 0)
+					ok = false;
+				sent += batch;
+			}
+			for (; sent < messages - 1; sent++) {
+				if (client->sendFrame(frame_ptrs[0]))
+					ok = false;
+			}
+			{
+				command::Send last(client);
+				last.destination("/queue/bench").body(body);
+				std::future<ReceiptTable::Result> receipt = client->sendCommandWithReceipt(&last);
+				if ((receipt.wait_for(std::chrono::seconds(10)) != std::future_status::ready) || (receipt.get().status != ReceiptTable::RECEIPT_OK))
+					ok = false;
+			}
+
+			result.frames = messages;
+			result.bytes = (uint64_t)messages * body.size();
+			return result;
+		}
+	};
+
+	/**
+	 * SEND frames to a subscribed destination, echoed back as MESSAGE frames.
+	 */
+	struct EchoCase {
+		BenchClient* client;
+		std::string body;
+		int messages;
+		bool ok;
+
+		bench::Runner::Result operator()() {
+			bench::Runner::Result result;
+			uint64_t expected = client->messages() + messages;
+			command::Send send(client);
+			send.destination("/topic/echo").body(body);
+			for (int i = 0; i < messages; i++) {
+				if (client->sendFrame(send.frame()))
+					ok = false;
+			}
+			if (!client->wait_messages(expected))
+				ok = false;
+			result.frames = messages;
+			result.bytes = (uint64_t)messages * body.size();
+			return result;
+		}
+	};
+
+}
+
+int main(int argc, char* argv[]) {
+	static const size_t body_sizes[] = { 64, 4096, 262144 };
+	static const int batch_sizes[] = { 1, 16 };
+	bench::Runner runner;
+	StandInBroker broker;
+	BenchClient client;
+	int messages = 10000;
+	bool ok = true;
+	size_t i;
+	size_t j;
+
+	for (int arg = 1; arg < argc; arg++) {
+		if (!strcmp(argv[arg], "--filter") && (arg + 1 < argc)) {
+			runner.set_filter(argv[++arg]);
+		}
+		else if (!strcmp(argv[arg], "--min-time") && (arg + 1 < argc)) {
+			runner.set_min_seconds(atof(argv[++arg]));
+		}
+		else if (!strcmp(argv[arg], "--messages") && (arg + 1 < argc)) {
+			messages = atoi(argv[++arg]);
+		}
+		else {
+			fprintf(stderr, "usage: %s [--filter TEXT] [--min-time SECONDS] [--messages N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (!broker.start() || !client.start(broker.port())) {
+		fprintf(stderr, "loopback broker: could not connect\n");
+		return 1;
+	}
+	{
+		command::Subscribe subscribe(&client, true);
+		subscribe.destination("/topic/echo");
+		client.sendCommand(&subscribe);
+	}
+
+	bench::Runner::print_header();
+
+	for (i = 0; i < sizeof(body_sizes) / sizeof(body_sizes[0]); i++) {
+		int count = (body_sizes[i] > 65536) ? messages / 100 + 1 : messages;
+		for (j = 0; j < sizeof(batch_sizes) / sizeof(batch_sizes[0]); j++) {
+			char label[64];
+			SendCase test_case;
+			test_case.client = &client;
+			test_case.body.assign(body_sizes[i], 'x');
+			test_case.messages = count;
+			test_case.batch = batch_sizes[j];
+			test_case.ok = true;
+			snprintf(label, sizeof(label), "send/body:%zu/batch:%d", body_sizes[i], batch_sizes[j]);
+			runner.run(label, test_case);
+			if (!test_case.ok) {
+				fprintf(stderr, "%s: send or receipt failed\n", label);
+				ok = false;
+			}
+		}
+		{
+			char label[64];
+			EchoCase test_case;
+			test_case.client = &client;
+			test_case.body.assign(body_sizes[i], 'x');
+			test_case.messages = count;
+			test_case.ok = true;
+			snprintf(label, sizeof(label), "echo/body:%zu", body_sizes[i]);
+			runner.run(label, test_case);
+			if (!test_case.ok) {
+				fprintf(stderr, "%s: messages missing\n", label);
+				ok = false;
+			}
+		}
+	}
+
+	return ok ? 0 : 1;
+}
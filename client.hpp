@@ -8,11 +8,22 @@
  */
 #pragma once
 
+#include <atomic>
+#include <future>
+#include <memory>
+
 #include "frame.hpp"
+#include "frame_view.hpp"
+#include "subscription_registry.hpp"
+#include "receipt_table.hpp"
 #include "command/base.hpp"
 
 namespace stomp {
 
+	namespace command {
+		class PreparedSend;
+	}
+
 	class Client {
 	public:
 		enum State {
@@ -21,25 +32,175 @@ namespace stomp {
 			CONNECTED = 2,
 		};
 
+		enum SendStatus {
+			SEND_OK = 0,
+			SEND_ERROR = -1,
+			SEND_QUEUE_FULL = -2,
+			SEND_TIMEOUT = -3,
+		};
+
 		class MessageBuffer {
 		public:
+			virtual ~MessageBuffer() {}
 			virtual char* data_ptr() = 0;
 			virtual int data_size() = 0;
 		};
 
+	private:
+		SubscriptionRegistry subscriptions_;
+		ReceiptTable receipts_;
+
 	public:
 		Client() {}
 		virtual ~Client() {}
 
 		virtual State state() const = 0;
 
+		/**
+		 * Handlers of MESSAGE frames by subscription id, see command::Subscribe::bind.
+		 * Messages of unregistered subscriptions go to onMessage.
+		 */
+		virtual SubscriptionRegistry* subscriptions() { return &subscriptions_; }
+
+		/**
+		 * Delivers a MESSAGE to the handler bound to its subscription, or to onMessage.
+		 */
+		int dispatchMessage(Frame* frame) {
+			if (!subscriptions()->empty()) {
+				SubscriptionHandler* handler = subscriptions()->find(frame->subscription());
+				if (handler)
+					return handler->onMessage(frame);
+			}
+			return onMessage(frame);
+		}
+
+		int dispatchMessageView(const FrameView& view) {
+			if (!subscriptions()->empty()) {
+				SubscriptionHandler* handler = subscriptions()->find(view.subscription());
+				if (handler)
+					return handler->onMessageView(view);
+			}
+			return onMessageView(view);
+		}
+
 		virtual int onConnected(Frame* frame) { return 0; }
 		virtual int onMessage(Frame* frame) { return 0; }
+		/**
+		 * Zero-copy MESSAGE delivery, used when the frame arrived in one receive chunk.
+		 * The default implementation materializes a Frame and calls onMessage.
+		 */
+		virtual int onMessageView(const FrameView& view) {
+			Frame frame;
+			view.to_frame(frame);
+			return onMessage(&frame);
+		}
+		/**
+		 * Streaming mode: headers of a large MESSAGE, followed by onMessageChunk calls.
+		 */
+		virtual int onMessageStart(Frame* frame) { return 0; }
+		virtual int onMessageChunk(const std::string& subscription, const char* data, int len, bool is_last) { return 0; }
 		virtual int onClosed() { return 0; }
+		/**
+		 * Nothing was received within the negotiated heart-beat interval (plus grace).
+		 * The connection is being closed, onClosed follows.
+		 */
+		virtual int onHeartbeatTimeout() { return 0; }
+		/**
+		 * ERROR frame from the server; the server closes the connection after it.
+		 */
+		virtual int onError(Frame* frame) { return 0; }
+		/**
+		 * The send queue drained below its low-water marks after a send was
+		 * refused with SEND_QUEUE_FULL.
+		 */
+		virtual int onSendQueueLow() { return 0; }
 
 		virtual int sendFrame(Frame *frame) = 0;
+		/**
+		 * Sends a frame whose body is taken over instead of copied.
+		 */
+		virtual int sendFrame(std::unique_ptr<Frame> frame) {
+			return sendFrame(frame.get());
+		}
+		/**
+		 * Like sendFrame, but fails with SEND_QUEUE_FULL instead of queueing past
+		 * the send queue limits.
+		 */
+		virtual int trySendFrame(Frame* frame) {
+			return sendFrame(frame);
+		}
+		/**
+		 * Waits up to timeout_ms (negative: no limit) for room in the send queue.
+		 * @return SEND_TIMEOUT if the queue stayed full.
+		 */
+		virtual int sendFrame(Frame* frame, int timeout_ms) {
+			return sendFrame(frame);
+		}
+
+		/**
+		 * Sends several frames, as one write where the transport allows it.
+		 */
+		virtual int sendFrames(Frame* const* frames, size_t count) {
+			int rc = 0;
+			for (size_t i = 0; (i < count) && !rc; i++)
+				rc = sendFrame(frames[i]);
+			return rc;
+		}
 
 		virtual int sendCommand(command::Base* item) = 0;
+		/**
+		 * Sends one message from a SEND template, see command::PreparedSend.
+		 */
+		virtual int sendPrepared(const command::PreparedSend* prepared, const char* body, size_t body_length) = 0;
+
+		/**
+		 * Requests in flight with a receipt header, see sendCommandWithReceipt.
+		 */
+		virtual ReceiptTable* receipts() { return &receipts_; }
+
+		/**
+		 * Sends item with a generated receipt header. callback runs when the
+		 * RECEIPT arrives (on the receiving thread), or when an ERROR names the
+		 * receipt or the connection closes first.
+		 * Waits up to timeout_ms (negative: no limit) while the receipt window
+		 * (ReceiptTable::set_window) is full.
+		 * @return SEND_OK, SEND_TIMEOUT or the sendCommand error; callback is
+		 *         not called when sending failed.
+		 */
+		int sendCommandWithReceipt(command::Base* item, const ReceiptTable::Callback& callback, int timeout_ms = -1) {
+			std::string receipt_id;
+			int rc;
+			if (!receipts()->acquire(timeout_ms))
+				return SEND_TIMEOUT;
+			receipt_id = receipts()->add(callback);
+			// Replaced, so a resent item carries the new id
+			item->frame()->replace_header(Frame::HEADER_RECEIPT, receipt_id);
+			rc = sendCommand(item);
+			if (rc)
+				receipts()->cancel(receipt_id);
+			return rc;
+		}
+
+		/**
+		 * Future flavour of sendCommandWithReceipt; a failed send completes the
+		 * future at once with status set to the send error.
+		 */
+		std::future<ReceiptTable::Result> sendCommandWithReceipt(command::Base* item, int timeout_ms = -1) {
+			std::shared_ptr<std::promise<ReceiptTable::Result> > promise = std::make_shared<std::promise<ReceiptTable::Result> >();
+			// A close can run the callback before a failed send cancels the receipt
+			std::shared_ptr<std::atomic<bool> > fulfilled = std::make_shared<std::atomic<bool> >(false);
+			std::future<ReceiptTable::Result> future = promise->get_future();
+			int rc = sendCommandWithReceipt(item, [promise, fulfilled](const ReceiptTable::Result& result) {
+				if (!fulfilled->exchange(true))
+					promise->set_value(result);
+			}, timeout_ms);
+			if (rc && !fulfilled->exchange(true)) {
+				ReceiptTable::Result result;
+				result.status = rc;
+				promise->set_value(result);
+			}
+			return future;
+		}
 
 		virtual std::string generateSubscribeId() = 0;
 		virtual std::string generateTransactionId() = 0;
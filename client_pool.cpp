@@ -0,0 +1,574 @@
+/**
+ * @file	client_pool.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "client_pool.hpp"
+
+#if defined(HAS_LIBWEBSOCKETS) && HAS_LIBWEBSOCKETS
+
+#include <string.h>
+#include <stdio.h>
+
+#include "command/prepared_send.hpp"
+
+namespace stomp {
+
+	ClientPool::ClientPool(int connection_count, int thread_count, MemoryResource* resource)
+		: memory_resource_(resource),
+		running_(false),
+		id_tx_count_(0),
+		id_sub_count_(0)
+	{
+		int i;
+		if (connection_count < 1)
+			connection_count = 1;
+		if (thread_count < 1)
+			thread_count = 1;
+		if (thread_count > connection_count)
+			thread_count = connection_count;
+		for (i = 0; i < thread_count; i++)
+			threads_.emplace_back(new ServiceThread(this));
+		for (i = 0; i < connection_count; i++) {
+			ServiceThread* service = threads_[i % thread_count].get();
+			connections_.emplace_back(new Connection(this, i, memory_resource_));
+			connections_.back()->setTimerWheel(&service->timer_wheel_);
+			service->connections_.push_back(connections_.back().get());
+		}
+	}
+
+	ClientPool::~ClientPool()
+	{
+		stop();
+	}
+
+	int ClientPool::start(const ConnectInfo& info)
+	{
+		static const struct lws_protocols protocols[] = {
+			{ "stomp", &ClientPool::callback, 0, 65536 },
+			{ NULL, NULL, 0, 0 }
+		};
+		const std::string& host = info.host.empty() ? info.address : info.host;
+		const std::string& origin = info.origin.empty() ? host : info.origin;
+		size_t i;
+
+		if (running_.load())
+			return -1;
+
+		for (i = 0; i < threads_.size(); i++) {
+			struct lws_context_creation_info context_info;
+			memset(&context_info, 0, sizeof(context_info));
+			context_info.port = CONTEXT_PORT_NO_LISTEN;
+			context_info.protocols = protocols;
+			context_info.user = threads_[i].get();
+			if (info.use_ssl)
+				context_info.options |= LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT;
+			threads_[i]->context_ = lws_create_context(&context_info);
+			if (!threads_[i]->context_) {
+				stop();
+				return -1;
+			}
+		}
+
+		for (i = 0; i < threads_.size(); i++) {
+			ServiceThread* service = threads_[i].get();
+			for (size_t j = 0; j < service->connections_.size(); j++) {
+				struct lws_client_connect_info connect_info;
+				memset(&connect_info, 0, sizeof(connect_info));
+				connect_info.context = service->context_;
+				connect_info.address = info.address.c_str();
+				connect_info.port = info.port;
+				connect_info.ssl_connection = info.use_ssl ? LCCSCF_USE_SSL : 0;
+				connect_info.path = info.path.c_str();
+				connect_info.host = host.c_str();
+				connect_info.origin = origin.c_str();
+				connect_info.protocol = info.protocol.c_str();
+				connect_info.userdata = service->connections_[j];
+				if (!lws_client_connect_via_info(&connect_info)) {
+					stop();
+					return -1;
+				}
+			}
+		}
+
+		running_.store(true);
+		for (i = 0; i < threads_.size(); i++) {
+			ServiceThread* service = threads_[i].get();
+			service->thread_ = std::thread(&ServiceThread::run, service);
+		}
+		return 0;
+	}
+
+	void ClientPool::stop()
+	{
+		size_t i;
+		running_.store(false);
+		for (i = 0; i < threads_.size(); i++) {
+			ServiceThread* service = threads_[i].get();
+			if (service->context_)
+				lws_cancel_service(service->context_);
+			if (service->thread_.joinable())
+				service->thread_.join();
+		}
+		for (i = 0; i < threads_.size(); i++) {
+			ServiceThread* service = threads_[i].get();
+			if (service->context_) {
+				lws_context_destroy(service->context_);
+				service->context_ = NULL;
+			}
+		}
+	}
+
+	void ClientPool::ServiceThread::run()
+	{
+		while (pool_->running_.load()) {
+			lws_service(context_, 0);
+			timer_wheel_.advance(std::chrono::steady_clock::now());
+		}
+	}
+
+	int ClientPool::callback(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len)
+	{
+		Connection* connection = (Connection*)user;
+		bool processed = false;
+		int rc;
+
+		if (reason == LWS_CALLBACK_EVENT_WAIT_CANCELLED) {
+			// Not tied to a connection: let every connection of the context check its queue
+			ServiceThread* service = (ServiceThread*)lws_context_user(lws_get_context(wsi));
+			if (service) {
+				for (size_t i = 0; i < service->connections_.size(); i++)
+					service->connections_[i]->callbackProtocol(wsi, reason, user, in, len, &processed);
+			}
+			return 0;
+		}
+
+		if (!connection)
+			return 0;
+		rc = connection->callbackProtocol(wsi, reason, user, in, len, &processed);
+		// With the shared wheel a connection arms its lws timer only for write
+		// linger; keep it ticking so lws_service returns to advance the wheel
+		if ((reason == LWS_CALLBACK_CLIENT_ESTABLISHED) || (reason == LWS_CALLBACK_TIMER))
+			lws_set_timer_usecs(wsi, LibwebsocketsClient::get_timer_period_us());
+		return rc;
+	}
+
+	int ClientPool::shardOf(const std::string& key) const
+	{
+		// FNV-1a, destinations are case-sensitive
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < key.size(); i++)
+			hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+		return (int)(hash % (uint32_t)connections_.size());
+	}
+
+	int ClientPool::connection_of(const std::string& destination) const
+	{
+		return shardOf(destination);
+	}
+
+	int ClientPool::sendOn(int shard, Frame* frame, SendMode mode, int timeout_ms)
+	{
+		switch (mode) {
+		case SEND_MODE_BOUNDED:
+			return connections_[shard]->trySendFrame(frame);
+		case SEND_MODE_WAIT:
+			return connections_[shard]->sendFrame(frame, timeout_ms);
+		default:
+			return connections_[shard]->sendFrame(frame);
+		}
+	}
+
+	/*
+	 * Moves shard to the connection the transaction is pinned to, or sends its
+	 * held BEGIN on shard and pins it there. BEGIN is queued under route_lock_,
+	 * so no frame of the transaction overtakes it.
+	 * @return SEND_OK, or the refusal of BEGIN, which then stays held
+	 */
+	int ClientPool::pinTransaction(const std::string& transaction, int* shard, SendMode mode, int timeout_ms)
+	{
+		std::unique_lock<std::mutex> lock(route_lock_);
+		std::unordered_map<std::string, int>::iterator iter = transaction_routes_.find(transaction);
+		std::unordered_map<std::string, Frame>::iterator begin;
+		int rc;
+		if (iter != transaction_routes_.end()) {
+			*shard = iter->second;
+			return SEND_OK;
+		}
+		begin = pending_begins_.find(transaction);
+		if (begin == pending_begins_.end()) {
+			// Not begun through the pool, routeSent pins it
+			return SEND_OK;
+		}
+		rc = sendOn(*shard, &begin->second, mode, timeout_ms);
+		if (rc != SEND_OK)
+			return rc;
+		pending_begins_.erase(begin);
+		transaction_routes_[transaction] = *shard;
+		return SEND_OK;
+	}
+
+	/*
+	 * Sends what must precede frame on its connection (a held BEGIN).
+	 * @param shard route(frame), moved to the transaction's connection
+	 */
+	int ClientPool::prepareRoute(Frame* frame, int* shard, SendMode mode, int timeout_ms)
+	{
+		switch (frame->command_id()) {
+		case Frame::COMMAND_SEND:
+		case Frame::COMMAND_COMMIT:
+		case Frame::COMMAND_ABORT:
+			if (frame->has_header(Frame::HEADER_TRANSACTION))
+				return pinTransaction(frame->header(Frame::HEADER_TRANSACTION), shard, mode, timeout_ms);
+			return SEND_OK;
+		default:
+			return SEND_OK;
+		}
+	}
+
+	/*
+	 * ACK / NACK go where the message came from even inside a transaction: the
+	 * broker only knows the message on the connection that delivered it.
+	 */
+	int ClientPool::route(Frame* frame)
+	{
+		std::unordered_map<std::string, int>::iterator iter;
+
+		switch (frame->command_id()) {
+		case Frame::COMMAND_SEND:
+		case Frame::COMMAND_SUBSCRIBE:
+			return shardOf(frame->destination());
+
+		case Frame::COMMAND_ACK:
+		case Frame::COMMAND_NACK:
+			if (frame->has_header(Frame::HEADER_ID)) {
+				std::unique_lock<std::mutex> lock(ack_route_lock_);
+				iter = ack_routes_.find(frame->header(Frame::HEADER_ID));
+				if (iter != ack_routes_.end())
+					return iter->second;
+			}
+			{
+				std::unique_lock<std::mutex> lock(route_lock_);
+				iter = subscription_routes_.find(frame->header(Frame::HEADER_SUBSCRIPTION));
+				return (iter != subscription_routes_.end()) ? iter->second : 0;
+			}
+
+		case Frame::COMMAND_UNSUBSCRIBE:
+			{
+				std::unique_lock<std::mutex> lock(route_lock_);
+				iter = subscription_routes_.find(frame->header(Frame::HEADER_ID));
+				return (iter != subscription_routes_.end()) ? iter->second : 0;
+			}
+
+		case Frame::COMMAND_BEGIN:
+			{
+				const std::string& transaction = frame->header(Frame::HEADER_TRANSACTION);
+				std::unique_lock<std::mutex> lock(route_lock_);
+				pending_begins_.erase(transaction);
+				pending_begins_.emplace(transaction, *frame);
+				return ROUTE_HELD;
+			}
+
+		case Frame::COMMAND_COMMIT:
+		case Frame::COMMAND_ABORT:
+			// A transaction without SEND frames gets its BEGIN on this one
+			return shardOf(frame->header(Frame::HEADER_TRANSACTION));
+
+		case Frame::COMMAND_DISCONNECT:
+			return ROUTE_ALL;
+
+		default:
+			return 0;
+		}
+	}
+
+	void ClientPool::routeSent(Frame* frame, int shard)
+	{
+		switch (frame->command_id()) {
+		case Frame::COMMAND_SEND:
+			if (frame->has_header(Frame::HEADER_TRANSACTION)) {
+				std::unique_lock<std::mutex> lock(route_lock_);
+				transaction_routes_.emplace(frame->header(Frame::HEADER_TRANSACTION), shard);
+			}
+			break;
+
+		case Frame::COMMAND_SUBSCRIBE:
+			{
+				std::unique_lock<std::mutex> lock(route_lock_);
+				subscription_routes_[frame->header(Frame::HEADER_ID)] = shard;
+			}
+			break;
+
+		case Frame::COMMAND_UNSUBSCRIBE:
+			{
+				std::unique_lock<std::mutex> lock(route_lock_);
+				subscription_routes_.erase(frame->header(Frame::HEADER_ID));
+			}
+			break;
+
+		case Frame::COMMAND_ACK:
+		case Frame::COMMAND_NACK:
+			if (frame->has_header(Frame::HEADER_ID)) {
+				std::unique_lock<std::mutex> lock(ack_route_lock_);
+				ack_routes_.erase(frame->header(Frame::HEADER_ID));
+			}
+			break;
+
+		case Frame::COMMAND_COMMIT:
+		case Frame::COMMAND_ABORT:
+			{
+				std::unique_lock<std::mutex> lock(route_lock_);
+				transaction_routes_.erase(frame->header(Frame::HEADER_TRANSACTION));
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	int ClientPool::sendRouted(Frame* frame, SendMode mode, int timeout_ms)
+	{
+		int shard = route(frame);
+		int rc = 0;
+		if (shard == ROUTE_HELD)
+			return SEND_OK;
+		if (shard == ROUTE_ALL) {
+			for (size_t i = 0; i < connections_.size(); i++) {
+				int item_rc = connections_[i]->sendFrame(frame);
+				if (item_rc && !rc)
+					rc = item_rc;
+			}
+			return rc;
+		}
+		rc = prepareRoute(frame, &shard, mode, timeout_ms);
+		if (rc != SEND_OK)
+			return rc;
+		rc = sendOn(shard, frame, mode, timeout_ms);
+		if (rc == SEND_OK)
+			routeSent(frame, shard);
+		return rc;
+	}
+
+	/*
+	 * Ack ids are only valid on the session that delivered the message.
+	 */
+	void ClientPool::dropAckRoutes(int shard)
+	{
+		std::unique_lock<std::mutex> lock(ack_route_lock_);
+		std::unordered_map<std::string, int>::iterator iter = ack_routes_.begin();
+		while (iter != ack_routes_.end()) {
+			if (iter->second == shard)
+				iter = ack_routes_.erase(iter);
+			else
+				++iter;
+		}
+	}
+
+	void ClientPool::setMessageDispatcher(MessageDispatcher* dispatcher, const std::string& key_header)
+	{
+		for (size_t i = 0; i < connections_.size(); i++)
+			connections_[i]->setMessageDispatcher(dispatcher, key_header);
+	}
+
+	size_t ClientPool::connection_count() const
+	{
+		return connections_.size();
+	}
+
+	LibwebsocketsClient* ClientPool::connection(size_t index)
+	{
+		return connections_[index].get();
+	}
+
+	Client::State ClientPool::state() const
+	{
+		State result = State::CONNECTED;
+		for (size_t i = 0; i < connections_.size(); i++) {
+			State state = connections_[i]->state();
+			if (state < result)
+				result = state;
+		}
+		return result;
+	}
+
+	int ClientPool::sendFrame(Frame* frame)
+	{
+		return sendRouted(frame, SEND_MODE_QUEUE, -1);
+	}
+
+	int ClientPool::sendFrame(std::unique_ptr<Frame> frame)
+	{
+		int shard = route(frame.get());
+		if (shard == ROUTE_HELD)
+			return SEND_OK;
+		if (shard == ROUTE_ALL)
+			return sendFrame(frame.get());
+		prepareRoute(frame.get(), &shard, SEND_MODE_QUEUE, -1);
+		// Unbounded, so always queued; the frame may be gone once it is
+		routeSent(frame.get(), shard);
+		return connections_[shard]->sendFrame(std::move(frame));
+	}
+
+	int ClientPool::trySendFrame(Frame* frame)
+	{
+		return sendRouted(frame, SEND_MODE_BOUNDED, 0);
+	}
+
+	int ClientPool::sendFrame(Frame* frame, int timeout_ms)
+	{
+		return sendRouted(frame, SEND_MODE_WAIT, timeout_ms);
+	}
+
+	int ClientPool::sendFrames(Frame* const* frames, size_t count)
+	{
+		std::vector<std::vector<Frame*> > shards(connections_.size());
+		std::vector<int> routes(count);
+		std::vector<int> results(connections_.size(), SEND_OK);
+		size_t i;
+		int rc = 0;
+		for (i = 0; i < count; i++) {
+			int shard = route(frames[i]);
+			routes[i] = shard;
+			if (shard == ROUTE_HELD)
+				continue;
+			if (shard == ROUTE_ALL) {
+				for (size_t j = 0; j < shards.size(); j++)
+					shards[j].push_back(frames[i]);
+				continue;
+			}
+			// A held BEGIN is queued right away, ahead of this batch
+			prepareRoute(frames[i], &shard, SEND_MODE_QUEUE, -1);
+			routes[i] = shard;
+			shards[shard].push_back(frames[i]);
+		}
+		for (i = 0; i < shards.size(); i++) {
+			if (shards[i].empty())
+				continue;
+			results[i] = connections_[i]->sendFrames(&shards[i][0], shards[i].size());
+			if (results[i] && !rc)
+				rc = results[i];
+		}
+		for (i = 0; i < count; i++) {
+			if ((routes[i] >= 0) && (results[routes[i]] == SEND_OK))
+				routeSent(frames[i], routes[i]);
+		}
+		return rc;
+	}
+
+	int ClientPool::sendCommand(command::Base* item)
+	{
+		return sendFrame(item->frame());
+	}
+
+	int ClientPool::sendPrepared(const command::PreparedSend* prepared, const char* body, size_t body_length)
+	{
+		int shard = shardOf(prepared->destination());
+		int rc;
+		if (!prepared->transaction().empty()) {
+			rc = pinTransaction(prepared->transaction(), &shard, SEND_MODE_BOUNDED, 0);
+			if (rc != SEND_OK)
+				return rc;
+		}
+		rc = connections_[shard]->sendPrepared(prepared, body, body_length);
+		if ((rc == SEND_OK) && !prepared->transaction().empty()) {
+			std::unique_lock<std::mutex> lock(route_lock_);
+			transaction_routes_.emplace(prepared->transaction(), shard);
+		}
+		return rc;
+	}
+
+	std::string ClientPool::generateSubscribeId()
+	{
+		char buf[128];
+		snprintf(buf, sizeof(buf), "sub-%llx", (unsigned long long)++id_sub_count_);
+		return buf;
+	}
+
+	std::string ClientPool::generateTransactionId()
+	{
+		char buf[128];
+		snprintf(buf, sizeof(buf), "tx-%llx", (unsigned long long)++id_tx_count_);
+		return buf;
+	}
+
+	int ClientPool::Connection::onConnected(Frame* frame)
+	{
+		return pool_->onConnected(frame);
+	}
+
+	int ClientPool::Connection::onMessage(Frame* frame)
+	{
+		return pool_->onMessage(frame);
+	}
+
+	int ClientPool::Connection::onMessageView(const FrameView& view)
+	{
+		return pool_->onMessageView(view);
+	}
+
+	int ClientPool::Connection::onMessageStart(Frame* frame)
+	{
+		return pool_->onMessageStart(frame);
+	}
+
+	int ClientPool::Connection::onMessageChunk(const std::string& subscription, const char* data, int len, bool is_last)
+	{
+		return pool_->onMessageChunk(subscription, data, len, is_last);
+	}
+
+	void ClientPool::Connection::onMessageAck(const StringRef& ack)
+	{
+		if (ack.empty())
+			return;
+		std::unique_lock<std::mutex> lock(pool_->ack_route_lock_);
+		pool_->ack_routes_[ack.to_string()] = index_;
+	}
+
+	int ClientPool::Connection::onClosed()
+	{
+		pool_->dropAckRoutes(index_);
+		return pool_->onClosed();
+	}
+
+	int ClientPool::Connection::onHeartbeatTimeout()
+	{
+		return pool_->onHeartbeatTimeout();
+	}
+
+	int ClientPool::Connection::onError(Frame* frame)
+	{
+		return pool_->onError(frame);
+	}
+
+	int ClientPool::Connection::onSendQueueLow()
+	{
+		return pool_->onSendQueueLow();
+	}
+
+	SubscriptionRegistry* ClientPool::Connection::subscriptions()
+	{
+		return pool_->subscriptions();
+	}
+
+	ReceiptTable* ClientPool::Connection::receipts()
+	{
+		return pool_->receipts();
+	}
+
+	std::string ClientPool::Connection::generateSubscribeId()
+	{
+		return pool_->generateSubscribeId();
+	}
+
+	std::string ClientPool::Connection::generateTransactionId()
+	{
+		return pool_->generateTransactionId();
+	}
+
+}
+
+#endif /* HAS_LIBWEBSOCKETS */
@@ -0,0 +1,228 @@
+/**
+ * @file	client_pool.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#if defined(HAS_LIBWEBSOCKETS) && HAS_LIBWEBSOCKETS
+
+#include "lws_client.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace stomp {
+
+	/**
+	 * Several STOMP connections spread over several lws contexts, each serviced
+	 * by its own thread, behind one Client.
+	 *
+	 * SEND and SUBSCRIBE go to the connection chosen by a hash of the destination,
+	 * so frames for one destination keep their order. ACK / NACK go to the
+	 * connection that delivered the message (by its ack id, falling back to the
+	 * subscription header), UNSUBSCRIBE follows its subscription, DISCONNECT
+	 * goes to every connection. Route changes (a new subscription, a
+	 * transaction pinned to a connection) take effect once the frame is queued,
+	 * so a send refused by the queue limits leaves them as they were.
+	 *
+	 * A transaction lives on one connection. BEGIN is held back until the first
+	 * SEND of the transaction and goes out just ahead of it on that SEND's
+	 * connection, which the rest of the transaction is pinned to; a receipt
+	 * requested on BEGIN therefore only arrives after that SEND. BEGIN is sent
+	 * the way that SEND is (bounded, or waiting for room with the route lock
+	 * held); if it is refused both stay unsent. A transaction
+	 * that sends to several destinations keeps the per-destination order for the
+	 * first one only: SENDs to the others travel on the pinned connection and
+	 * may pass non-transacted frames sent to them meanwhile.
+	 *
+	 * The connections of a service thread share one TimerWheel for heart-beats,
+	 * advanced by that thread.
+	 *
+	 * Callbacks (onConnected, onMessage, ...) come from the service thread of the
+	 * connection and may run concurrently; onConnected / onClosed are called once
+	 * per connection. Subscription handlers and receipts are shared by the
+	 * connections, so a closing connection fails every receipt in flight.
+	 */
+	class ClientPool : public Client {
+	public:
+		struct ConnectInfo {
+			std::string address;
+			int port;
+			std::string path;
+			std::string host;
+			std::string origin;
+			// WebSocket sub-protocol
+			std::string protocol;
+			bool use_ssl;
+
+			ConnectInfo()
+				: port(80), path("/"), protocol("v11.stomp"), use_ssl(false) {}
+		};
+
+	private:
+		class ServiceThread;
+
+		class Connection : public LibwebsocketsClient {
+		private:
+			ClientPool* pool_;
+			int index_;
+
+		protected:
+			void onMessageAck(const StringRef& ack) override;
+
+		public:
+			Connection(ClientPool* pool, int index, MemoryResource* resource)
+				: LibwebsocketsClient(true, resource), pool_(pool), index_(index) {}
+
+			int onConnected(Frame* frame) override;
+			int onMessage(Frame* frame) override;
+			int onMessageView(const FrameView& view) override;
+			int onMessageStart(Frame* frame) override;
+			int onMessageChunk(const std::string& subscription, const char* data, int len, bool is_last) override;
+			int onClosed() override;
+			int onHeartbeatTimeout() override;
+			int onError(Frame* frame) override;
+			int onSendQueueLow() override;
+
+			SubscriptionRegistry* subscriptions() override;
+			ReceiptTable* receipts() override;
+			std::string generateSubscribeId() override;
+			std::string generateTransactionId() override;
+		};
+
+		class ServiceThread {
+		public:
+			ClientPool* pool_;
+			struct lws_context* context_;
+			std::vector<Connection*> connections_;
+			// Heart-beats of connections_, see LibwebsocketsClient::setTimerWheel
+			TimerWheel timer_wheel_;
+			std::thread thread_;
+
+			ServiceThread(ClientPool* pool)
+				: pool_(pool), context_(NULL),
+				timer_wheel_(std::chrono::microseconds(LibwebsocketsClient::get_timer_period_us())) {}
+
+			void run();
+		};
+
+		MemoryResource* memory_resource_;
+		std::vector<std::unique_ptr<Connection> > connections_;
+		std::vector<std::unique_ptr<ServiceThread> > threads_;
+		std::atomic<bool> running_;
+
+		// Subscription id / transaction id -> connection index; BEGIN frames wait
+		// in pending_begins_ until their transaction is pinned to a connection
+		std::mutex route_lock_;
+		std::unordered_map<std::string, int> subscription_routes_;
+		std::unordered_map<std::string, int> transaction_routes_;
+		std::unordered_map<std::string, Frame> pending_begins_;
+		// MESSAGE ack id -> connection that delivered it, until its ACK / NACK is
+		// sent or the connection closes. With cumulative (client) acks the ids a
+		// later ACK covered stay until then.
+		std::mutex ack_route_lock_;
+		std::unordered_map<std::string, int> ack_routes_;
+
+		std::atomic<int64_t> id_tx_count_;
+		std::atomic<int64_t> id_sub_count_;
+
+		ClientPool(const ClientPool& o);
+		ClientPool& operator=(const ClientPool& o);
+
+		static int callback(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len);
+
+		enum {
+			ROUTE_ALL = -1,
+			ROUTE_HELD = -2
+		};
+
+		// How a frame (and a held BEGIN ahead of it) is queued on its connection
+		enum SendMode {
+			SEND_MODE_QUEUE,
+			SEND_MODE_BOUNDED,
+			SEND_MODE_WAIT
+		};
+
+		int shardOf(const std::string& key) const;
+		int sendOn(int shard, Frame* frame, SendMode mode, int timeout_ms);
+		int pinTransaction(const std::string& transaction, int* shard, SendMode mode, int timeout_ms);
+		int prepareRoute(Frame* frame, int* shard, SendMode mode, int timeout_ms);
+		/**
+		 * Looks the connection up without changing any route.
+		 * @return Connection index for frame, ROUTE_ALL to send it to every
+		 *         connection, ROUTE_HELD if the pool keeps it (BEGIN).
+		 */
+		int route(Frame* frame);
+		/**
+		 * Applies the route changes of frame once it was queued on shard.
+		 */
+		void routeSent(Frame* frame, int shard);
+		int sendRouted(Frame* frame, SendMode mode, int timeout_ms);
+		void dropAckRoutes(int shard);
+
+	public:
+		/**
+		 * @param connection_count Connections to open
+		 * @param thread_count     lws contexts / service threads, connections are spread round-robin
+		 * @param resource         Memory for pooled Frame objects, shared by the connections
+		 *                         and so used from every service thread; it must be thread
+		 *                         safe (a MonotonicBufferResource is not) and outlive the pool
+		 */
+		ClientPool(int connection_count, int thread_count, MemoryResource* resource = NULL);
+		virtual ~ClientPool();
+
+		/**
+		 * Creates the contexts, starts connecting and starts the service threads.
+		 * @return 0 on success, -1 if a context or connection could not be created.
+		 */
+		int start(const ConnectInfo& info);
+		/**
+		 * Stops the service threads and destroys the contexts (closing the connections).
+		 */
+		void stop();
+
+		/**
+		 * See LibwebsocketsClient::setMessageDispatcher; applies to every connection.
+		 */
+		void setMessageDispatcher(MessageDispatcher* dispatcher, const std::string& key_header = std::string());
+
+		size_t connection_count() const;
+		LibwebsocketsClient* connection(size_t index);
+
+		/**
+		 * @return Connection index that frames for destination are sent on.
+		 */
+		int connection_of(const std::string& destination) const;
+
+		/**
+		 * CONNECTED only when every connection is.
+		 */
+		State state() const override;
+
+		int sendFrame(Frame* frame) override;
+		int sendFrame(std::unique_ptr<Frame> frame) override;
+		int trySendFrame(Frame* frame) override;
+		int sendFrame(Frame* frame, int timeout_ms) override;
+		/**
+		 * One write per connection the frames route to.
+		 */
+		int sendFrames(Frame* const* frames, size_t count) override;
+		int sendCommand(command::Base* item) override;
+		int sendPrepared(const command::PreparedSend* prepared, const char* body, size_t body_length) override;
+
+		std::string generateSubscribeId() override;
+		std::string generateTransactionId() override;
+	};
+
+}
+
+#endif /* HAS_LIBWEBSOCKETS */
@@ -21,17 +21,61 @@ namespace stomp {
 		class Ack : public Base {
 		public:
 			Ack(Client *client)
-				: Base(Frame::Commands::SUBSCRIBE)
+				: Base(Frame::Commands::ACK)
 			{
 			}
 
+			/**
+			 * STOMP 1.2: the ack header of the MESSAGE.
+			 */
+			Ack& id(const std::string& value) {
+				frame_.header(Frame::HEADER_ID, value);
+				return *this;
+			}
+
+			/**
+			 * STOMP 1.0 / 1.1: the message-id and subscription headers of the MESSAGE.
+			 */
+			Ack& message_id(const std::string& value) {
+				frame_.header(Frame::HEADER_MESSAGE_ID, value);
+				return *this;
+			}
+
+			Ack& subscription(const std::string& value) {
+				frame_.header(Frame::HEADER_SUBSCRIPTION, value);
+				return *this;
+			}
+
 			Ack& transaction(const std::string& value) {
-				frame_.header("transaction", value);
+				frame_.header(Frame::HEADER_TRANSACTION, value);
 				return *this;
 			}
 
+			/**
+			 * Fills id / message-id / subscription from a received MESSAGE.
+			 */
+			Ack& message(const Frame* frame) {
+				if (frame->has_header(Frame::HEADER_ACK))
+					id(frame->header(Frame::HEADER_ACK));
+				message_id(frame->messageId());
+				subscription(frame->subscription());
+				return *this;
+			}
+
+			const std::string& id() {
+				return frame_.header(Frame::HEADER_ID);
+			}
+
+			const std::string& message_id() {
+				return frame_.header(Frame::HEADER_MESSAGE_ID);
+			}
+
+			const std::string& subscription() {
+				return frame_.header(Frame::HEADER_SUBSCRIPTION);
+			}
+
 			const std::string& transaction() {
-				return frame_.header("transaction");
+				return frame_.header(Frame::HEADER_TRANSACTION);
 			}
 		};
 
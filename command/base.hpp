@@ -12,6 +12,8 @@
 #include <assert.h>
 #endif
 
+#include <memory>
+
 #include "../frame.hpp"
 
 namespace stomp {
@@ -35,6 +37,14 @@ namespace stomp {
 			Frame* frame() {
 				return &frame_;
 			}
+			/**
+			 * Moves the frame (including its body) out, leaving this command empty.
+			 */
+			std::unique_ptr<Frame> take_frame() {
+				std::unique_ptr<Frame> frame(new Frame());
+				frame->swap(frame_);
+				return frame;
+			}
 		};
 
 	}
@@ -21,14 +21,19 @@ namespace stomp {
 		class Begin : public Base {
 		public:
 			Begin(Client *client, bool auto_id = false)
-				: Base(Frame::Commands::SUBSCRIBE)
+				: Base(Frame::Commands::BEGIN)
 			{
 				if(auto_id)
-					frame_.header("transaction", client->generateTransactionId());
+					frame_.header(Frame::HEADER_TRANSACTION, client->generateTransactionId());
+			}
+
+			Begin& transaction(const std::string& value) {
+				frame_.header(Frame::HEADER_TRANSACTION, value);
+				return *this;
 			}
 
 			const std::string& transaction() {
-				return frame_.header("transaction");
+				return frame_.header(Frame::HEADER_TRANSACTION);
 			}
 		};
 
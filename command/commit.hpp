@@ -21,17 +21,17 @@ namespace stomp {
 		class Commit : public Base {
 		public:
 			Commit(Client* client)
-				: Base(Frame::Commands::SUBSCRIBE)
+				: Base(Frame::Commands::COMMIT)
 			{
 			}
 
 			Commit& transaction(const std::string& value) {
-				frame_.header("transaction", value);
+				frame_.header(Frame::HEADER_TRANSACTION, value);
 				return *this;
 			}
 
 			const std::string& transaction() {
-				return frame_.header("transaction");
+				return frame_.header(Frame::HEADER_TRANSACTION);
 			}
 		};
 
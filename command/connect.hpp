@@ -24,8 +24,8 @@ namespace stomp {
 				: Base(Frame::Commands::CONNECT)
 			{
 				frame_
-					.header(Frame::Headers::ACCEPT_VERSION, "1.1,1.0")
-					.header(Frame::Headers::HEART_BEAT, "10000,10000");
+					.header(Frame::HEADER_ACCEPT_VERSION, "1.1,1.0")
+					.header(Frame::HEADER_HEART_BEAT, "10000,10000");
 			}
 		};
 
@@ -21,17 +21,17 @@ namespace stomp {
 		class Disconnect : public Base {
 		public:
 			Disconnect(Client *client)
-				: Base(Frame::Commands::SUBSCRIBE)
+				: Base(Frame::Commands::DISCONNECT)
 			{
 			}
 
 			Disconnect& receipt(const std::string& value) {
-				frame_.header("receipt", value);
+				frame_.header(Frame::HEADER_RECEIPT, value);
 				return *this;
 			}
 
 			const std::string& receipt() const {
-				return frame_.header("receipt");
+				return frame_.header(Frame::HEADER_RECEIPT);
 			}
 
 		};
@@ -0,0 +1,128 @@
+/**
+ * @file	prepared_send.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../frame.hpp"
+#include "../client.hpp"
+
+namespace stomp {
+
+	namespace command {
+
+		/**
+		 * SEND template: the command line and fixed headers are encoded once,
+		 * each message only adds content-length and the body.
+		 */
+		class PreparedSend {
+		private:
+			Client* client_;
+			Frame frame_;
+			// "SEND\n" followed by the encoded fixed header lines
+			std::vector<char> prefix_;
+
+			void prepare() {
+				prefix_.clear();
+				frame_.make_header_block_append(prefix_);
+				// Drop the blank line, content-length goes after the fixed headers
+				prefix_.pop_back();
+			}
+
+			static size_t format_length(char* buf, size_t value) {
+				char temp[24];
+				size_t n = 0;
+				size_t i;
+				do {
+					temp[n++] = (char)('0' + (value % 10));
+					value /= 10;
+				} while (value);
+				for (i = 0; i < n; i++)
+					buf[i] = temp[n - i - 1];
+				return n;
+			}
+
+		public:
+			PreparedSend(Client* client)
+				: client_(client), frame_(Frame::Commands::SEND)
+			{
+				prepare();
+			}
+
+			PreparedSend& header(const std::string& name, const std::string& value) {
+				frame_.header(name, value);
+				prepare();
+				return *this;
+			}
+
+			PreparedSend& header(Frame::HeaderId id, const std::string& value) {
+				frame_.header(id, value);
+				prepare();
+				return *this;
+			}
+
+			PreparedSend& destination(const std::string& value) {
+				return header(Frame::HEADER_DESTINATION, value);
+			}
+
+			PreparedSend& transaction(const std::string& value) {
+				return header(Frame::HEADER_TRANSACTION, value);
+			}
+
+			PreparedSend& content_type(const std::string& value) {
+				return header(Frame::HEADER_CONTENT_TYPE, value);
+			}
+
+			const std::string& destination() const {
+				return frame_.header(Frame::HEADER_DESTINATION);
+			}
+
+			const std::string& transaction() const {
+				return frame_.header(Frame::HEADER_TRANSACTION);
+			}
+
+			const std::string& content_type() const {
+				return frame_.header(Frame::HEADER_CONTENT_TYPE);
+			}
+
+			/**
+			 * @return Size of the complete frame for a body of body_length bytes.
+			 */
+			size_t payload_size(size_t body_length) const {
+				char digits[24];
+				return prefix_.size() + Frame::Headers::CONTENT_LENGTH.size() + 1 + format_length(digits, body_length) + 2 + body_length + 1;
+			}
+
+			void make_payload_append(const char* body, size_t body_length, std::vector<char>& output) const {
+				static const char separator[2] = { '\n', '\n' };
+				char digits[24];
+				size_t digits_length = format_length(digits, body_length);
+				output.reserve(output.size() + payload_size(body_length));
+				output.insert(output.end(), prefix_.begin(), prefix_.end());
+				output.insert(output.end(), Frame::Headers::CONTENT_LENGTH.begin(), Frame::Headers::CONTENT_LENGTH.end());
+				output.push_back(':');
+				output.insert(output.end(), digits, digits + digits_length);
+				output.insert(output.end(), separator, separator + 2);
+				output.insert(output.end(), body, body + body_length);
+				output.push_back(0);
+			}
+
+			int send(const char* body, size_t body_length) {
+				return client_->sendPrepared(this, body, body_length);
+			}
+
+			int send(const std::string& body) {
+				return send(body.data(), body.size());
+			}
+		};
+
+	}
+
+}
@@ -28,38 +28,38 @@ namespace stomp {
 			}
 
 			Send& destination(const std::string& value) {
-				frame_.header("destination", value);
+				frame_.header(Frame::HEADER_DESTINATION, value);
 				return *this;
 			}
 
 			Send& transaction(const std::string& value) {
-				frame_.header("transaction", value);
+				frame_.header(Frame::HEADER_TRANSACTION, value);
 				return *this;
 			}
 
 			Send& content_type(const std::string& value) {
-				frame_.header(Frame::Headers::CONTENT_TYPE, value);
+				frame_.header(Frame::HEADER_CONTENT_TYPE, value);
 				return *this;
 			}
 
 			Send& body(const std::string& value) {
 				char buf[64];
 				snprintf(buf, sizeof(buf), "%d", value.length());
-				frame_.header(Frame::Headers::CONTENT_LENGTH, buf);
+				frame_.header(Frame::HEADER_CONTENT_LENGTH, buf);
 				frame_.body(value);
 				return *this;
 			}
 
 			const std::string& destination() {
-				return frame_.header("destination");
+				return frame_.header(Frame::HEADER_DESTINATION);
 			}
 
 			const std::string& transaction() {
-				return frame_.header("transaction");
+				return frame_.header(Frame::HEADER_TRANSACTION);
 			}
 
 			const std::string& content_type() {
-				return frame_.header(Frame::Headers::CONTENT_TYPE);
+				return frame_.header(Frame::HEADER_CONTENT_TYPE);
 			}
 
 			const int content_length() {
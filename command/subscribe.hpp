@@ -11,6 +11,7 @@
 #include <string>
 
 #include "base.hpp"
+#include "unsubscribe.hpp"
 #include "../frame.hpp"
 #include "../client.hpp"
 
@@ -19,39 +20,101 @@ namespace stomp {
 	namespace command {
 
 		class Subscribe : public Base {
+		public:
+			/**
+			 * Subscription registered by bind(). Copyable; does not unsubscribe by itself.
+			 */
+			class Handle {
+			private:
+				Client* client_;
+				std::string id_;
+
+			public:
+				Handle()
+					: client_(NULL) {}
+				Handle(Client* client, const std::string& id)
+					: client_(client), id_(id) {}
+
+				bool valid() const {
+					return client_ != NULL;
+				}
+				const std::string& id() const {
+					return id_;
+				}
+
+				/**
+				 * Removes the handler; later MESSAGE frames go to Client::onMessage.
+				 */
+				void unbind() {
+					if (client_)
+						client_->subscriptions()->remove(id_);
+					client_ = NULL;
+				}
+
+				/**
+				 * Sends UNSUBSCRIBE and removes the handler.
+				 */
+				int unsubscribe() {
+					int rc;
+					if (!client_)
+						return -1;
+					Unsubscribe command(client_);
+					command.id(id_);
+					rc = client_->sendCommand(&command);
+					unbind();
+					return rc;
+				}
+			};
+
+		private:
+			Client* client_;
+
 		public:
 			Subscribe(Client *client, bool auto_id = true)
-				: Base(Frame::Commands::SUBSCRIBE)
+				: Base(Frame::Commands::SUBSCRIBE), client_(client)
 			{
 				if(auto_id)
-					frame_.header("id", client->generateSubscribeId());
+					frame_.header(Frame::HEADER_ID, client->generateSubscribeId());
 			}
 
 			Subscribe& id(const std::string& value) {
-				frame_.header("id", value);
+				frame_.header(Frame::HEADER_ID, value);
 				return *this;
 			}
 
 			Subscribe& destination(const std::string& value) {
-				frame_.header("destination", value);
+				frame_.header(Frame::HEADER_DESTINATION, value);
 				return *this;
 			}
 
 			Subscribe& ack(const std::string& value) {
-				frame_.header("ack", value);
+				frame_.header(Frame::HEADER_ACK, value);
 				return *this;
 			}
 
+			/**
+			 * Routes the MESSAGE frames of this subscription to handler.
+			 * Call after setting the id and before sending, so no message is missed.
+			 */
+			Handle bind(const std::shared_ptr<SubscriptionHandler>& handler) {
+				client_->subscriptions()->add(id(), handler);
+				return Handle(client_, id());
+			}
+
+			Handle bind(const std::function<int(Frame*)>& function) {
+				return bind(std::make_shared<FunctionSubscriptionHandler>(function));
+			}
+
 			const std::string& id() {
-				return frame_.header("id");
+				return frame_.header(Frame::HEADER_ID);
 			}
 
 			const std::string& destination() {
-				return frame_.header("destination");
+				return frame_.header(Frame::HEADER_DESTINATION);
 			}
 
 			const std::string& ack() {
-				return frame_.header("ack");
+				return frame_.header(Frame::HEADER_ACK);
 			}
 		};
 
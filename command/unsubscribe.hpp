@@ -26,12 +26,12 @@ namespace stomp {
 			}
 
 			Unsubscribe& id(const std::string& value) {
-				frame_.header("id", value);
+				frame_.header(Frame::HEADER_ID, value);
 				return *this;
 			}
 
 			const std::string& id() {
-				return frame_.header("id");
+				return frame_.header(Frame::HEADER_ID);
 			}
 		};
 
@@ -0,0 +1,256 @@
+/**
+ * @file	destination_router.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "destination_router.hpp"
+
+#include <string.h>
+
+namespace stomp {
+
+	bool DestinationRouter::Node::empty() const
+	{
+		return children_.empty() && !any_one_ && exact_.empty() && one_or_more_.empty() && zero_or_more_.empty();
+	}
+
+	void DestinationRouter::MatchList::add(const HandlerPtr& handler)
+	{
+		size_t i;
+		// Matches per lookup are few, a linear duplicate check is cheapest
+		for (i = 0; i < size_; i++) {
+			if (at(i) == handler)
+				return;
+		}
+		if (size_ < INLINE_COUNT)
+			inline_[size_] = handler;
+		else
+			more_.push_back(handler);
+		size_++;
+	}
+
+	const DestinationRouter::HandlerPtr& DestinationRouter::MatchList::at(size_t index) const
+	{
+		return (index < INLINE_COUNT) ? inline_[index] : more_[index - INLINE_COUNT];
+	}
+
+	DestinationRouter::DestinationRouter(const std::string& separators)
+		: separators_(separators), pattern_count_(0)
+	{
+		memset(is_separator_, 0, sizeof(is_separator_));
+		for (size_t i = 0; i < separators_.size(); i++)
+			is_separator_[(unsigned char)separators_[i]] = true;
+	}
+
+	void DestinationRouter::split(const StringRef& text, std::vector<StringRef>& segments) const
+	{
+		const char* begin = text.data();
+		const char* end = begin + text.size();
+		const char* p;
+		for (p = begin; p < end; p++) {
+			if (is_separator_[(unsigned char)*p]) {
+				segments.push_back(StringRef(begin, p - begin));
+				begin = p + 1;
+			}
+		}
+		segments.push_back(StringRef(begin, end - begin));
+	}
+
+	int DestinationRouter::add(const std::string& pattern, const HandlerPtr& handler)
+	{
+		std::vector<StringRef> segments;
+		Node* node = &root_;
+		size_t last;
+		size_t i;
+
+		split(pattern, segments);
+		last = segments.size() - 1;
+		for (i = 0; i < last; i++) {
+			if (segments[i].equals(">") || segments[i].equals("#"))
+				return -1;
+		}
+
+		std::unique_lock<std::mutex> lock(lock_);
+		for (i = 0; i < last; i++) {
+			std::unique_ptr<Node>& child = segments[i].equals("*") ? node->any_one_ : node->children_[segments[i].to_string()];
+			if (!child)
+				child.reset(new Node());
+			node = child.get();
+		}
+
+		if (segments[last].equals(">")) {
+			node->one_or_more_.push_back(handler);
+		}
+		else if (segments[last].equals("#")) {
+			node->zero_or_more_.push_back(handler);
+		}
+		else {
+			std::unique_ptr<Node>& child = segments[last].equals("*") ? node->any_one_ : node->children_[segments[last].to_string()];
+			if (!child)
+				child.reset(new Node());
+			child->exact_.push_back(handler);
+		}
+		pattern_count_++;
+		return 0;
+	}
+
+	int DestinationRouter::add(const std::string& pattern, const std::function<int(Frame*)>& function)
+	{
+		return add(pattern, std::make_shared<FunctionSubscriptionHandler>(function));
+	}
+
+	bool DestinationRouter::remove_path(Node* node, const std::vector<StringRef>& segments, size_t index, const SubscriptionHandler* handler)
+	{
+		std::vector<HandlerPtr>* list = NULL;
+		std::unique_ptr<Node>* child;
+		bool removed;
+
+		if (index == segments.size()) {
+			list = &node->exact_;
+		}
+		else if (index + 1 == segments.size()) {
+			if (segments[index].equals(">"))
+				list = &node->one_or_more_;
+			else if (segments[index].equals("#"))
+				list = &node->zero_or_more_;
+		}
+
+		if (list) {
+			for (std::vector<HandlerPtr>::iterator iter = list->begin(); iter != list->end(); iter++) {
+				if (iter->get() == handler) {
+					list->erase(iter);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		if (segments[index].equals("*")) {
+			child = &node->any_one_;
+		}
+		else {
+			std::unordered_map<std::string, std::unique_ptr<Node> >::iterator iter = node->children_.find(segments[index].to_string());
+			if (iter == node->children_.end())
+				return false;
+			child = &iter->second;
+		}
+		if (!*child)
+			return false;
+		removed = remove_path(child->get(), segments, index + 1, handler);
+		// Prune branches left without patterns
+		if (removed && (*child)->empty()) {
+			if (child == &node->any_one_)
+				node->any_one_.reset();
+			else
+				node->children_.erase(segments[index].to_string());
+		}
+		return removed;
+	}
+
+	bool DestinationRouter::remove(const std::string& pattern, const SubscriptionHandler* handler)
+	{
+		std::vector<StringRef> segments;
+		split(pattern, segments);
+		std::unique_lock<std::mutex> lock(lock_);
+		if (!remove_path(&root_, segments, 0, handler))
+			return false;
+		pattern_count_--;
+		return true;
+	}
+
+	void DestinationRouter::clear()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		root_.children_.clear();
+		root_.any_one_.reset();
+		root_.exact_.clear();
+		root_.one_or_more_.clear();
+		root_.zero_or_more_.clear();
+		pattern_count_ = 0;
+	}
+
+	size_t DestinationRouter::size() const
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return pattern_count_;
+	}
+
+	/*
+	 * begin: start of the next segment, NULL once every segment is consumed.
+	 */
+	void DestinationRouter::match_node(const Node* node, const char* begin, const char* end, std::string& key, MatchList& matches) const
+	{
+		const char* p;
+		const char* next;
+		size_t i;
+
+		for (i = 0; i < node->zero_or_more_.size(); i++)
+			matches.add(node->zero_or_more_[i]);
+		if (!begin) {
+			for (i = 0; i < node->exact_.size(); i++)
+				matches.add(node->exact_[i]);
+			return;
+		}
+		for (i = 0; i < node->one_or_more_.size(); i++)
+			matches.add(node->one_or_more_[i]);
+
+		for (p = begin; (p < end) && !is_separator_[(unsigned char)*p]; p++) {}
+		next = (p < end) ? (p + 1) : NULL;
+
+		if (!node->children_.empty()) {
+			std::unordered_map<std::string, std::unique_ptr<Node> >::const_iterator iter;
+			// Reuses key's capacity (and short segments fit the SSO buffer)
+			key.assign(begin, p - begin);
+			iter = node->children_.find(key);
+			if (iter != node->children_.end())
+				match_node(iter->second.get(), next, end, key, matches);
+		}
+		if (node->any_one_)
+			match_node(node->any_one_.get(), next, end, key, matches);
+	}
+
+	void DestinationRouter::match(const StringRef& destination, MatchList& matches) const
+	{
+		std::string key;
+		std::unique_lock<std::mutex> lock(lock_);
+		match_node(&root_, destination.data(), destination.data() + destination.size(), key, matches);
+	}
+
+	void DestinationRouter::match(const StringRef& destination, std::vector<HandlerPtr>& out) const
+	{
+		MatchList matches;
+		match(destination, matches);
+		for (size_t i = 0; i < matches.size(); i++)
+			out.push_back(matches.at(i));
+	}
+
+	int DestinationRouter::onMessage(Frame* frame)
+	{
+		MatchList matches;
+		int rc = 0;
+		match(frame->destination(), matches);
+		for (size_t i = 0; i < matches.size(); i++) {
+			int item_rc = matches.at(i)->onMessage(frame);
+			if (item_rc && !rc)
+				rc = item_rc;
+		}
+		return rc;
+	}
+
+	int DestinationRouter::onMessageView(const FrameView& view)
+	{
+		MatchList matches;
+		int rc = 0;
+		match(view.destination(), matches);
+		for (size_t i = 0; i < matches.size(); i++) {
+			int item_rc = matches.at(i)->onMessageView(view);
+			if (item_rc && !rc)
+				rc = item_rc;
+		}
+		return rc;
+	}
+
+}
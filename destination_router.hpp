@@ -0,0 +1,114 @@
+/**
+ * @file	destination_router.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "string_ref.hpp"
+#include "subscription_registry.hpp"
+
+namespace stomp {
+
+	/**
+	 * Local fan-out of MESSAGE frames by destination.
+	 *
+	 * Patterns are split into segments at any of the separator characters and
+	 * compiled into a segment trie:
+	 * - `*` matches exactly one segment
+	 * - `>` as the last segment matches one or more segments
+	 * - `#` as the last segment matches zero or more segments
+	 * so `/topic/prices.>` matches `/topic/prices.AAPL` and `/topic/prices.fx.EUR`.
+	 *
+	 * A lookup visits at most two children per destination segment, independent
+	 * of the number of patterns. A handler matched by several patterns is called
+	 * once. The router is a SubscriptionHandler, so it can be bound to a broad
+	 * broker subscription (see command::Subscribe::bind).
+	 */
+	class DestinationRouter : public SubscriptionHandler {
+	public:
+		typedef std::shared_ptr<SubscriptionHandler> HandlerPtr;
+
+	private:
+		struct Node {
+			std::unordered_map<std::string, std::unique_ptr<Node> > children_;
+			std::unique_ptr<Node> any_one_;
+			// Patterns ending here
+			std::vector<HandlerPtr> exact_;
+			// Patterns ending here with ">" / "#"
+			std::vector<HandlerPtr> one_or_more_;
+			std::vector<HandlerPtr> zero_or_more_;
+
+			bool empty() const;
+		};
+
+		// Handlers matched by one lookup; small lookups stay off the heap
+		class MatchList {
+		private:
+			enum { INLINE_COUNT = 16 };
+			HandlerPtr inline_[INLINE_COUNT];
+			std::vector<HandlerPtr> more_;
+			size_t size_;
+
+		public:
+			MatchList() : size_(0) {}
+			void add(const HandlerPtr& handler);
+			size_t size() const { return size_; }
+			const HandlerPtr& at(size_t index) const;
+		};
+
+		std::string separators_;
+		bool is_separator_[256];
+		mutable std::mutex lock_;
+		Node root_;
+		size_t pattern_count_;
+
+		DestinationRouter(const DestinationRouter& o);
+		DestinationRouter& operator=(const DestinationRouter& o);
+
+		void split(const StringRef& text, std::vector<StringRef>& segments) const;
+		void match_node(const Node* node, const char* begin, const char* end, std::string& key, MatchList& matches) const;
+		void match(const StringRef& destination, MatchList& matches) const;
+		static bool remove_path(Node* node, const std::vector<StringRef>& segments, size_t index, const SubscriptionHandler* handler);
+
+	public:
+		DestinationRouter(const std::string& separators = "/.");
+
+		/**
+		 * @return 0, or -1 if ">" / "#" is not the last segment of pattern
+		 */
+		int add(const std::string& pattern, const HandlerPtr& handler);
+		int add(const std::string& pattern, const std::function<int(Frame*)>& function);
+		/**
+		 * Removes one registration of handler under pattern.
+		 * @return true if it was registered
+		 */
+		bool remove(const std::string& pattern, const SubscriptionHandler* handler);
+		void clear();
+
+		size_t size() const;
+
+		/**
+		 * Appends the handlers matching destination (each once) to out.
+		 */
+		void match(const StringRef& destination, std::vector<HandlerPtr>& out) const;
+
+		/**
+		 * Calls every matching handler.
+		 * @return First non-zero handler result, or 0
+		 */
+		int onMessage(Frame* frame) override;
+		int onMessageView(const FrameView& view) override;
+	};
+
+}
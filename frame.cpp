@@ -7,9 +7,13 @@
  *            of the Apache License 2.0.  See the LICENSE file for details.
  */
 #include "frame.hpp"
+#include "header_names.hpp"
+#include "scanner.hpp"
 
 #include <vector>
+#include <algorithm>
 
+#include <stdlib.h>
 #include <string.h>
 
 #if !defined(_MSC_VER)
@@ -20,14 +24,39 @@ namespace stomp {
 
 	const std::string
 		Frame::Commands::CONNECT("CONNECT"),
+		Frame::Commands::STOMP("STOMP"),
 		Frame::Commands::CONNECTED("CONNECTED"),
 		Frame::Commands::SUBSCRIBE("SUBSCRIBE"),
 		Frame::Commands::UNSUBSCRIBE("UNSUBSCRIBE"),
+		Frame::Commands::ACK("ACK"),
+		Frame::Commands::NACK("NACK"),
+		Frame::Commands::BEGIN("BEGIN"),
+		Frame::Commands::COMMIT("COMMIT"),
 		Frame::Commands::ABORT("ABORT"),
+		Frame::Commands::DISCONNECT("DISCONNECT"),
 		Frame::Commands::MESSAGE("MESSAGE"),
+		Frame::Commands::RECEIPT("RECEIPT"),
 		Frame::Commands::SEND("SEND")
 		;
 
+	static const char* const known_command_names[Frame::COMMAND_KNOWN_COUNT] = {
+		"CONNECT",
+		"STOMP",
+		"CONNECTED",
+		"SEND",
+		"SUBSCRIBE",
+		"UNSUBSCRIBE",
+		"ACK",
+		"NACK",
+		"BEGIN",
+		"COMMIT",
+		"ABORT",
+		"DISCONNECT",
+		"MESSAGE",
+		"RECEIPT",
+		"ERROR"
+	};
+
 	const std::string
 		Frame::Headers::CONTENT_TYPE("content-type"),
 		Frame::Headers::CONTENT_LENGTH("content-length"),
@@ -35,53 +64,194 @@ namespace stomp {
 		Frame::Headers::HEART_BEAT("heart-beat")
 		;
 
+	static_assert(header_names::count == Frame::HEADER_KNOWN_COUNT, "header_names must list every Frame::HeaderId");
+
+#define STOMP_HEADER_SLOT(n) ((signed char)header_names::id_of_slot(n))
+	// Perfect hash slot -> HeaderId, computed at compile time
+	static const signed char header_slot_table[header_names::SLOT_COUNT] = {
+		STOMP_HEADER_SLOT(0), STOMP_HEADER_SLOT(1), STOMP_HEADER_SLOT(2), STOMP_HEADER_SLOT(3),
+		STOMP_HEADER_SLOT(4), STOMP_HEADER_SLOT(5), STOMP_HEADER_SLOT(6), STOMP_HEADER_SLOT(7),
+		STOMP_HEADER_SLOT(8), STOMP_HEADER_SLOT(9), STOMP_HEADER_SLOT(10), STOMP_HEADER_SLOT(11),
+		STOMP_HEADER_SLOT(12), STOMP_HEADER_SLOT(13), STOMP_HEADER_SLOT(14), STOMP_HEADER_SLOT(15),
+		STOMP_HEADER_SLOT(16), STOMP_HEADER_SLOT(17), STOMP_HEADER_SLOT(18), STOMP_HEADER_SLOT(19),
+		STOMP_HEADER_SLOT(20), STOMP_HEADER_SLOT(21), STOMP_HEADER_SLOT(22), STOMP_HEADER_SLOT(23),
+		STOMP_HEADER_SLOT(24), STOMP_HEADER_SLOT(25), STOMP_HEADER_SLOT(26), STOMP_HEADER_SLOT(27),
+		STOMP_HEADER_SLOT(28), STOMP_HEADER_SLOT(29), STOMP_HEADER_SLOT(30), STOMP_HEADER_SLOT(31)
+	};
+#undef STOMP_HEADER_SLOT
+
+#define STOMP_HEADER_HASH(id) header_names::hash(header_names::names[id], header_names::length(header_names::names[id]))
+	static const uint32_t header_hash_table[Frame::HEADER_KNOWN_COUNT] = {
+		STOMP_HEADER_HASH(0), STOMP_HEADER_HASH(1), STOMP_HEADER_HASH(2), STOMP_HEADER_HASH(3),
+		STOMP_HEADER_HASH(4), STOMP_HEADER_HASH(5), STOMP_HEADER_HASH(6), STOMP_HEADER_HASH(7),
+		STOMP_HEADER_HASH(8), STOMP_HEADER_HASH(9), STOMP_HEADER_HASH(10), STOMP_HEADER_HASH(11),
+		STOMP_HEADER_HASH(12), STOMP_HEADER_HASH(13), STOMP_HEADER_HASH(14), STOMP_HEADER_HASH(15),
+		STOMP_HEADER_HASH(16), STOMP_HEADER_HASH(17), STOMP_HEADER_HASH(18)
+	};
+#undef STOMP_HEADER_HASH
+	static_assert(header_names::SLOT_COUNT == 32, "header_slot_table must have SLOT_COUNT entries");
+
 	Frame::Frame()
-		: empty_value_(), prediction_size_(0)
-	{}
+		: empty_value_(), command_id_(COMMAND_UNKNOWN), header_count_(0), prediction_size_(0)
+	{
+		for (int i = 0; i < HEADER_KNOWN_COUNT; i++)
+			known_slots_[i] = -1;
+	}
 
 	Frame::Frame(const std::string& command)
-		: empty_value_(), prediction_size_(0), command_(command)
-	{}
+		: empty_value_(), command_(command), command_id_(command_id(command.data(), command.size())), header_count_(0), prediction_size_(0)
+	{
+		for (int i = 0; i < HEADER_KNOWN_COUNT; i++)
+			known_slots_[i] = -1;
+	}
 
 	Frame& Frame::command(const std::string& value) {
 		command_ = value;
+		command_id_ = command_id(value.data(), value.size());
 		return *this;
 	}
 	const std::string& Frame::command() const {
 		return command_;
 	}
+	Frame::CommandId Frame::command_id() const {
+		return command_id_;
+	}
+
+	Frame::CommandId Frame::command_id(const char* command, size_t length) {
+		for (int i = 0; i < COMMAND_KNOWN_COUNT; i++) {
+			const char* known = known_command_names[i];
+			if ((strlen(known) == length) && (memcmp(known, command, length) == 0))
+				return (CommandId)i;
+		}
+		return COMMAND_UNKNOWN;
+	}
 
 	static void string_to_lower(std::string &text) {
 		for (std::string::iterator iter = text.begin(); iter != text.end(); iter++)
 		{
-			*iter = tolower(*iter);
+			*iter = header_names::ascii_lower(*iter);
 		}
 	}
 
+	static bool equals_lower(const char* lower, size_t lower_length, const char* name, size_t length) {
+		if (lower_length != length)
+			return false;
+		for (size_t i = 0; i < length; i++) {
+			if (lower[i] != header_names::ascii_lower(name[i]))
+				return false;
+		}
+		return true;
+	}
+
+	Frame::HeaderId Frame::header_id(const char* name, size_t length, uint32_t& hash) {
+		int id;
+		hash = header_names::runtime_hash(name, length);
+		id = header_slot_table[header_names::slot_of_hash(hash)];
+		if ((id >= 0) && equals_lower(header_names::names[id], strlen(header_names::names[id]), name, length))
+			return (HeaderId)id;
+		return HEADER_UNKNOWN;
+	}
+
+	Frame::HeaderId Frame::header_id(const char* name, size_t length) {
+		uint32_t hash;
+		return header_id(name, length, hash);
+	}
+
+	const char* Frame::header_name(HeaderId id) {
+		if ((id < 0) || (id >= HEADER_KNOWN_COUNT))
+			return "";
+		return header_names::names[id];
+	}
+
+	int Frame::find_header(const char* name, size_t length, HeaderId id, uint32_t hash) const {
+		if (id != HEADER_UNKNOWN)
+			return known_slots_[id];
+		for (size_t i = 0; i < header_count_; i++) {
+			const HeaderEntry& entry = headers_[i];
+			if ((entry.hash == hash) && equals_lower(entry.name.data(), entry.name.size(), name, length))
+				return (int)i;
+		}
+		return -1;
+	}
+
+	int Frame::find_header(const char* name, size_t length) const {
+		uint32_t hash;
+		HeaderId id = header_id(name, length, hash);
+		return find_header(name, length, id, hash);
+	}
+
+	Frame& Frame::add_header(HeaderId id, uint32_t hash, const char* name, size_t name_length, const char* value, size_t value_length) {
+		// First occurrence wins
+		if (find_header(name, name_length, id, hash) >= 0)
+			return *this;
+		if (header_count_ == headers_.size()) {
+			if (headers_.empty())
+				headers_.reserve(8);
+			headers_.push_back(HeaderEntry());
+		}
+		if (id != HEADER_UNKNOWN)
+			known_slots_[id] = (int)header_count_;
+		HeaderEntry& entry = headers_[header_count_++];
+		entry.name.assign(name, name_length);
+		string_to_lower(entry.name);
+		entry.value.assign(value, value_length);
+		entry.hash = hash;
+		prediction_size_ += header_encoded_size(name, name_length) + header_encoded_size(value, value_length) + 2;
+		return *this;
+	}
+
 	Frame& Frame::header(const std::string& name, const std::string& value) {
-		std::string lower_name(name);
-		string_to_lower(lower_name);
-		headers_.emplace(lower_name, value);
-		prediction_size_ += name.size() + value.size() + 2;
+		return header(name.data(), name.size(), value.data(), value.size());
+	}
+	Frame& Frame::header(const char* name, size_t name_length, const char* value, size_t value_length) {
+		uint32_t hash;
+		HeaderId id = header_id(name, name_length, hash);
+		return add_header(id, hash, name, name_length, value, value_length);
+	}
+	Frame& Frame::header(HeaderId id, const std::string& value) {
+		const char* name = header_names::names[id];
+		return add_header(id, header_hash_table[id], name, strlen(name), value.data(), value.size());
+	}
+	Frame& Frame::replace_header(HeaderId id, const std::string& value) {
+		int index = known_slots_[id];
+		if (index < 0)
+			return header(id, value);
+		HeaderEntry& entry = headers_[index];
+		prediction_size_ -= header_encoded_size(entry.value.data(), entry.value.size());
+		prediction_size_ += header_encoded_size(value.data(), value.size());
+		entry.value = value;
 		return *this;
 	}
 	const std::string& Frame::header(const std::string& name) const {
-		std::string lower_name(name);
-		string_to_lower(lower_name);
-		std::unordered_map<std::string, std::string>::const_iterator iter = headers_.find(lower_name);
-		if (iter != headers_.end()) {
-			return iter->second;
+		int index = find_header(name.data(), name.size());
+		if (index >= 0) {
+			return headers_[index].value;
 		}
 		return empty_value_;
 	}
+	const std::string& Frame::header(HeaderId id) const {
+		int index = known_slots_[id];
+		if (index < 0)
+			return empty_value_;
+		return headers_[index].value;
+	}
 
 	bool Frame::has_header(const std::string& name) const
 	{
-		std::unordered_map<std::string, std::string>::const_iterator iter = headers_.find(name);
-		if (iter != headers_.end()) {
-			return true;
-		}
-		return false;
+		return find_header(name.data(), name.size()) >= 0;
+	}
+
+	bool Frame::has_header(HeaderId id) const
+	{
+		return known_slots_[id] >= 0;
+	}
+
+	size_t Frame::header_count() const {
+		return header_count_;
+	}
+
+	const Frame::HeaderEntry& Frame::header_at(size_t index) const {
+		return headers_[index];
 	}
 
 	Frame& Frame::body(const std::string& value) {
@@ -97,76 +267,95 @@ namespace stomp {
 		return body_;
 	}
 
-	std::string Frame::destination() const
+	const std::string& Frame::destination() const
 	{
-		for (std::unordered_map<std::string, std::string>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++)
-		{
-			if (iter->first == "destination")
-				return iter->second;
-		}
-		return "";
+		return header(HEADER_DESTINATION);
 	}
 
-	std::string Frame::contentType() const
+	const std::string& Frame::contentType() const
 	{
-		for (std::unordered_map<std::string, std::string>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++)
-		{
-			if (iter->first == "content-type")
-				return iter->second;
-		}
-		return "";
+		return header(HEADER_CONTENT_TYPE);
 	}
 
-	std::string Frame::subscription() const
+	const std::string& Frame::subscription() const
 	{
-		for (std::unordered_map<std::string, std::string>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++)
-		{
-			if (iter->first == "subscription")
-				return iter->second;
-		}
-		return "";
+		return header(HEADER_SUBSCRIPTION);
 	}
 
-	std::string Frame::messageId() const
+	const std::string& Frame::messageId() const
 	{
-		for (std::unordered_map<std::string, std::string>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++)
-		{
-			if (iter->first == "message-id")
-				return iter->second;
-		}
-		return "";
+		return header(HEADER_MESSAGE_ID);
 	}
 
 	int Frame::contentLength() const
 	{
-		for (std::unordered_map<std::string, std::string>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++)
+		int index = known_slots_[HEADER_CONTENT_LENGTH];
+		if (index >= 0)
 		{
-			if (iter->first == "content-length")
-			{
-				return atoi(iter->second.c_str());
-			}
+			return atoi(headers_[index].value.c_str());
 		}
 		return body_.size();
 	}
 
-	void Frame::make_payload_append(std::vector<char>& output) const {
-		output.reserve(command_.size() + headers_.size() * 32 + body_.size() + 32);
+	void Frame::swap(Frame& other) {
+		command_.swap(other.command_);
+		std::swap(command_id_, other.command_id_);
+		headers_.swap(other.headers_);
+		std::swap(header_count_, other.header_count_);
+		for (int i = 0; i < HEADER_KNOWN_COUNT; i++)
+			std::swap(known_slots_[i], other.known_slots_[i]);
+		body_.swap(other.body_);
+		std::swap(prediction_size_, other.prediction_size_);
+	}
+
+	void Frame::clear() {
+		command_.clear();
+		command_id_ = COMMAND_UNKNOWN;
+		header_count_ = 0;
+		for (int i = 0; i < HEADER_KNOWN_COUNT; i++)
+			known_slots_[i] = -1;
+		body_.clear();
+		prediction_size_ = 0;
+	}
+
+	size_t Frame::header_block_size() const {
+		return command_.size() + 1 + prediction_size_ + 1;
+	}
+
+	void Frame::make_header_block_append(std::vector<char>& output) const {
 		output.insert(output.end(), command_.begin(), command_.end());
 		output.push_back('\n');
-		for (std::unordered_map<std::string, std::string>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++)
+		for (std::vector<HeaderEntry>::const_iterator iter = headers_.begin(); iter != headers_.begin() + header_count_; iter++)
 		{
-			std::string encoded_key(header_encode(iter->first));
-			std::string encoded_value(header_encode(iter->second));
-			output.insert(output.end(), encoded_key.begin(), encoded_key.end());
+			header_encode_append(iter->name.data(), iter->name.size(), output);
 			output.push_back(':');
-			output.insert(output.end(), encoded_value.begin(), encoded_value.end());
+			header_encode_append(iter->value.data(), iter->value.size(), output);
 			output.push_back('\n');
 		}
 		output.push_back('\n');
+	}
+
+	void Frame::make_payload_append(std::vector<char>& output) const {
+		output.reserve(output.size() + header_block_size() + body_.size() + 1);
+		make_header_block_append(output);
 		output.insert(output.end(), body_.begin(), body_.end());
 		output.push_back(0);
 	}
 
+	int Frame::make_payload_segments(std::vector<char>& head, PayloadSegment segments[3]) const {
+		static const char trailer[1] = { 0 };
+		size_t head_offset = head.size();
+		head.reserve(head_offset + header_block_size());
+		make_header_block_append(head);
+		segments[0].data = &head[head_offset];
+		segments[0].size = head.size() - head_offset;
+		segments[1].data = body_.data();
+		segments[1].size = body_.size();
+		segments[2].data = trailer;
+		segments[2].size = 1;
+		return 3;
+	}
+
 	std::vector<char> Frame::make_payload() const {
 		std::vector<char> temp;
 		make_payload_append(temp);
@@ -249,93 +438,103 @@ namespace stomp {
 		return 0; // non-validated
 	}
 
-	std::string Frame::header_encode(const std::string& raw)
+	static const char* header_escape_sequence(char c)
 	{
-		std::string output;
-		int n = raw.size();
-		int i = 0;
-		output.reserve(raw.size() + 16);
-
-		for (i = 0; i < n; i++)
+		switch (c)
 		{
-			const char* ptr = &raw[i];
-			int m = utf8_bytes(ptr, n - i);
-			if (m <= 1)
-			{
-				char c = *ptr;
-				switch (c)
+		case '\r':
+			return "\\r";
+		case '\n':
+			return "\\n";
+		case ':':
+			return "\\c";
+		default:
+			return "\\\\";
+		}
+	}
+
+	void Frame::header_encode_append(const char* raw, size_t length, std::vector<char>& output)
+	{
+		const char* end = raw + length;
+		const char* special = Scanner::find_header_escape(raw, end);
+
+		output.insert(output.end(), raw, special);
+		while (special != end) {
+			const char* escaped = header_escape_sequence(*special);
+			output.insert(output.end(), escaped, escaped + 2);
+			raw = special + 1;
+			special = Scanner::find_header_escape(raw, end);
+			output.insert(output.end(), raw, special);
+		}
+	}
+
+	size_t Frame::header_encoded_size(const char* raw, size_t length)
+	{
+		const char* end = raw + length;
+		const char* special = Scanner::find_header_escape(raw, end);
+		size_t size = length;
+		while (special != end) {
+			size++;
+			special = Scanner::find_header_escape(special + 1, end);
+		}
+		return size;
+	}
+
+	size_t Frame::header_decode_inplace(char* text, size_t length)
+	{
+		const char* end = text + length;
+		const char* read_ptr = Scanner::find_byte(text, end, '\\');
+		char* write_ptr = (char*)read_ptr;
+
+		while (read_ptr != end) {
+			const char* next;
+			char c = 0;
+			if ((read_ptr + 1) < end) {
+				switch (read_ptr[1])
 				{
-				case '\r':
-					output.append("\\r");
+				case 'r':
+					c = '\r';
 					break;
-				case '\n':
-					output.append("\\n");
+				case 'n':
+					c = '\n';
 					break;
-				case ':':
-					output.append("\\c");
+				case 'c':
+					c = ':';
 					break;
 				case '\\':
-					output.append("\\\\");
+					c = '\\';
 					break;
-				default:
-					output.append(&c, 1);
 				}
 			}
+			if (c) {
+				*(write_ptr++) = c;
+				read_ptr += 2;
+			}
 			else {
-				output.append(ptr, m);
+				// Undefined escape, kept as is
+				*(write_ptr++) = *(read_ptr++);
 			}
+			next = Scanner::find_byte(read_ptr, end, '\\');
+			memmove(write_ptr, read_ptr, next - read_ptr);
+			write_ptr += next - read_ptr;
+			read_ptr = next;
 		}
-		return output;
+		return write_ptr - text;
 	}
 
-	std::string Frame::header_decode(const std::string& encoded)
+	std::string Frame::header_encode(const std::string& raw)
 	{
-		std::string output;
-		int n = encoded.size();
-		int i = 0;
-		output.reserve(encoded.size());
+		std::vector<char> output;
+		output.reserve(raw.size() + 16);
+		header_encode_append(raw.data(), raw.size(), output);
+		return std::string(output.begin(), output.end());
+	}
 
-		for (i = 0; i < n; i++)
-		{
-			bool spec_char = false;
-			const char* ptr = &encoded[i];
-			int m = utf8_bytes(ptr, n - i);
-			if (m <= 1)
-			{
-				char c = *ptr;
-				int remaining = n - i - 1;
-				if (c == '\\')
-				{
-					if (remaining > 0)
-					{
-						char c = ptr[1];
-						switch (c)
-						{
-						case 'r':
-							output.append("\r");
-							spec_char = true;
-							break;
-						case 'n':
-							output.append("\n");
-							spec_char = true;
-							break;
-						case 'c':
-							output.append(":");
-							spec_char = true;
-							break;
-						case '\\':
-							output.append("\\");
-							spec_char = true;
-							break;
-						}
-					}
-				}
-			}
-			if (spec_char)
-				i++;
-			else
-				output.append(ptr, m);
-		}
+	std::string Frame::header_decode(const std::string& encoded)
+	{
+		std::string output(encoded);
+		if (!output.empty())
+			output.resize(header_decode_inplace(&output[0], output.size()));
 		return output;
 	}
 
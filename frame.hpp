@@ -10,30 +10,108 @@
 
 #include <string>
 #include <list>
-#include <unordered_map>
 #include <vector>
 
+#include <stdint.h>
+
 namespace stomp {
 
 	class Frame {
+	public:
+		enum CommandId {
+			COMMAND_UNKNOWN = -1,
+			COMMAND_CONNECT = 0,
+			COMMAND_STOMP,
+			COMMAND_CONNECTED,
+			COMMAND_SEND,
+			COMMAND_SUBSCRIBE,
+			COMMAND_UNSUBSCRIBE,
+			COMMAND_ACK,
+			COMMAND_NACK,
+			COMMAND_BEGIN,
+			COMMAND_COMMIT,
+			COMMAND_ABORT,
+			COMMAND_DISCONNECT,
+			COMMAND_MESSAGE,
+			COMMAND_RECEIPT,
+			COMMAND_ERROR,
+			COMMAND_KNOWN_COUNT
+		};
+
+		enum HeaderId {
+			HEADER_UNKNOWN = -1,
+			HEADER_DESTINATION = 0,
+			HEADER_ID,
+			HEADER_ACK,
+			HEADER_RECEIPT,
+			HEADER_RECEIPT_ID,
+			HEADER_MESSAGE_ID,
+			HEADER_SUBSCRIPTION,
+			HEADER_CONTENT_LENGTH,
+			HEADER_CONTENT_TYPE,
+			HEADER_TRANSACTION,
+			HEADER_HEART_BEAT,
+			HEADER_ACCEPT_VERSION,
+			HEADER_VERSION,
+			HEADER_HOST,
+			HEADER_LOGIN,
+			HEADER_PASSCODE,
+			HEADER_SERVER,
+			HEADER_SESSION,
+			HEADER_MESSAGE,
+			HEADER_KNOWN_COUNT
+		};
+
+		struct HeaderEntry {
+			std::string name;
+			std::string value;
+			// Case-insensitive hash of name, see header_names::hash
+			uint32_t hash;
+		};
+
+		struct PayloadSegment {
+			const char* data;
+			size_t size;
+		};
+
 	private:
 		const std::string empty_value_;
 
 	protected:
 		std::string command_;
-		std::unordered_map<std::string, std::string> headers_;
+		CommandId command_id_;
+		// Headers in insertion order, names lowercased.
+		// Entries past header_count_ are kept for reuse after clear().
+		std::vector<HeaderEntry> headers_;
+		size_t header_count_;
+		// Index into headers_ of each well-known header, or -1
+		int known_slots_[HEADER_KNOWN_COUNT];
 		std::string body_;
 
+		// Exact size of the encoded header lines
 		size_t prediction_size_;
 
+		int find_header(const char* name, size_t length) const;
+		int find_header(const char* name, size_t length, HeaderId id, uint32_t hash) const;
+		Frame& add_header(HeaderId id, uint32_t hash, const char* name, size_t name_length, const char* value, size_t value_length);
+
+		static HeaderId header_id(const char* name, size_t length, uint32_t& hash);
+
 	public:
 		struct Commands {
 			static const std::string CONNECT;
+			static const std::string STOMP;
 			static const std::string CONNECTED;
 			static const std::string SUBSCRIBE;
 			static const std::string UNSUBSCRIBE;
+			static const std::string ACK;
+			static const std::string NACK;
+			static const std::string BEGIN;
+			static const std::string COMMIT;
 			static const std::string ABORT;
+			static const std::string DISCONNECT;
 			static const std::string MESSAGE;
+			static const std::string RECEIPT;
 			static const std::string SEND;
 		};
 
@@ -48,26 +126,81 @@ namespace stomp {
 		Frame(const std::string& command);
 		Frame& command(const std::string& value);
 		const std::string& command() const;
+		CommandId command_id() const;
 		Frame& header(const std::string& name, const std::string& value);
+		Frame& header(const char* name, size_t name_length, const char* value, size_t value_length);
 		const std::string& header(const std::string& key) const;
 		bool has_header(const std::string& key) const;
+		Frame& header(HeaderId id, const std::string& value);
+		/**
+		 * Sets header id, overwriting a present value; header() keeps the first.
+		 */
+		Frame& replace_header(HeaderId id, const std::string& value);
+		const std::string& header(HeaderId id) const;
+		bool has_header(HeaderId id) const;
+		size_t header_count() const;
+		const HeaderEntry& header_at(size_t index) const;
 		Frame& body(const std::string& value);
 		std::string& refValue();
 		const std::string& body() const;
 
-		std::string destination() const;
-		std::string contentType() const;
-		std::string subscription() const;
-		std::string messageId() const;
+		const std::string& destination() const;
+		const std::string& contentType() const;
+		const std::string& subscription() const;
+		const std::string& messageId() const;
 		int contentLength() const;
 
+		void swap(Frame& other);
+		/**
+		 * Empties the frame but keeps allocated capacity for reuse.
+		 */
+		void clear();
+
 		void make_payload_append(std::vector<char>& output) const;
 		std::vector<char> make_payload() const;
 
+		/**
+		 * @return Exact size of the command line, header lines and blank line.
+		 */
+		size_t header_block_size() const;
+		void make_header_block_append(std::vector<char>& output) const;
+		/**
+		 * Scatter-gather serialization: appends the header block to head and fills
+		 * segments with { head block, body, NUL trailer }. The body segment
+		 * references this frame's body, which must outlive the segments.
+		 * @return Number of segments (3)
+		 */
+		int make_payload_segments(std::vector<char>& head, PayloadSegment segments[3]) const;
+
 		static std::string header_encode(const std::string& raw);
 		static std::string header_decode(const std::string& encoded);
 
+		/**
+		 * Appends the escaped form of raw to output without temporaries.
+		 */
+		static void header_encode_append(const char* raw, size_t length, std::vector<char>& output);
+		static size_t header_encoded_size(const char* raw, size_t length);
+		/**
+		 * Unescapes text in place (decoding only shrinks).
+		 * @return Decoded length
+		 */
+		static size_t header_decode_inplace(char* text, size_t length);
+
 		static int utf8_bytes(const char* string, int remainlen);
+
+		/**
+		 * Case-insensitive classification of a header name through the compile-time
+		 * perfect hash in header_names.hpp. Does not allocate.
+		 * @return HEADER_UNKNOWN if name is not a well-known STOMP header.
+		 */
+		static HeaderId header_id(const char* name, size_t length);
+		static const char* header_name(HeaderId id);
+
+		/**
+		 * Classifies a command line (case-sensitive).
+		 * @return COMMAND_UNKNOWN if command is not a STOMP command.
+		 */
+		static CommandId command_id(const char* command, size_t length);
 	};
 }
 
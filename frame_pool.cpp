@@ -0,0 +1,67 @@
+/**
+ * @file	frame_pool.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "frame_pool.hpp"
+
+#include <new>
+
+namespace stomp {
+
+	FramePool::FramePool(size_t max_cached, MemoryResource* resource)
+		: resource_(resource ? resource : MemoryResource::new_delete()),
+		max_cached_(max_cached)
+	{
+		free_frames_.reserve(max_cached);
+	}
+
+	FramePool::~FramePool()
+	{
+		for (std::vector<Frame*>::iterator iter = free_frames_.begin(); iter != free_frames_.end(); iter++)
+			destroy(*iter);
+	}
+
+	MemoryResource* FramePool::resource() const
+	{
+		return resource_;
+	}
+
+	Frame* FramePool::acquire()
+	{
+		{
+			std::unique_lock<std::mutex> lock(lock_);
+			if (!free_frames_.empty()) {
+				Frame* frame = free_frames_.back();
+				free_frames_.pop_back();
+				return frame;
+			}
+		}
+		return new (resource_->allocate(sizeof(Frame), alignof(Frame))) Frame();
+	}
+
+	void FramePool::release(Frame* frame)
+	{
+		if (!frame)
+			return;
+		frame->clear();
+		{
+			std::unique_lock<std::mutex> lock(lock_);
+			if (free_frames_.size() < max_cached_) {
+				free_frames_.push_back(frame);
+				return;
+			}
+		}
+		destroy(frame);
+	}
+
+	void FramePool::destroy(Frame* frame)
+	{
+		frame->~Frame();
+		resource_->deallocate(frame, sizeof(Frame), alignof(Frame));
+	}
+
+}
@@ -0,0 +1,51 @@
+/**
+ * @file	frame_pool.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <vector>
+#include <mutex>
+
+#include "frame.hpp"
+#include "memory_resource.hpp"
+
+namespace stomp {
+
+	/**
+	 * Recycles Frame objects together with the capacity of their strings.
+	 * The Frame objects themselves are constructed in memory from the given
+	 * MemoryResource, which must outlive the pool; their header and body
+	 * storage comes from std::allocator.
+	 */
+	class FramePool {
+	private:
+		MemoryResource* resource_;
+		size_t max_cached_;
+
+		std::mutex lock_;
+		std::vector<Frame*> free_frames_;
+
+		FramePool(const FramePool& o);
+		FramePool& operator=(const FramePool& o);
+
+		void destroy(Frame* frame);
+
+	public:
+		FramePool(size_t max_cached = 64, MemoryResource* resource = NULL);
+		~FramePool();
+
+		MemoryResource* resource() const;
+
+		/**
+		 * @return An empty frame, to be given back with release().
+		 */
+		Frame* acquire();
+		void release(Frame* frame);
+	};
+
+}
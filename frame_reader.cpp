@@ -7,15 +7,12 @@
  *            of the Apache License 2.0.  See the LICENSE file for details.
  */
 #include "frame_reader.hpp"
+#include "scanner.hpp"
 
 #include <vector>
 
 #include <string.h>
 
-#if !defined(_MSC_VER)
-#define strtok_s strtok_r
-#endif
-
 namespace stomp {
 
 	static void trim_end_type1(char* text) {
@@ -33,21 +30,88 @@ namespace stomp {
 		return len;
 	}
 
-	static int my_strlen_s(const char* text, int max_length)
+	namespace {
+		class FrameListHandler : public FrameHandler {
+		private:
+			std::list< std::unique_ptr<Frame> >& out_;
+
+		public:
+			FrameListHandler(std::list< std::unique_ptr<Frame> >& out)
+				: out_(out) {}
+
+			int onFrame(Frame* frame) override {
+				std::unique_ptr<Frame> item(new Frame());
+				item->swap(*frame);
+				out_.emplace_back(std::move(item));
+				return 0;
+			}
+
+			int onFrameView(const FrameView& view) override {
+				std::unique_ptr<Frame> frame(new Frame());
+				view.to_frame(*frame);
+				out_.emplace_back(std::move(frame));
+				return 0;
+			}
+		};
+	}
+
+	FrameReader::FrameReader()
+		: reading_frame_(NULL), streaming_threshold_(0), max_frame_size_(get_default_max_frame_size()), frame_pool_(NULL)
+	{
+		reset();
+	}
+
+	FrameReader::~FrameReader()
+	{
+		releaseReadingFrame();
+	}
+
+	void FrameReader::set_frame_pool(FramePool* pool)
+	{
+		releaseReadingFrame();
+		frame_pool_ = pool;
+	}
+
+	void FrameReader::set_streaming_threshold(int threshold)
+	{
+		streaming_threshold_ = threshold;
+	}
+
+	void FrameReader::set_max_frame_size(size_t bytes)
 	{
-		int cnt = 0;
-		while (*(text++) && cnt < max_length)
-			cnt++;
-		return cnt;
+		max_frame_size_ = bytes;
+	}
+
+	size_t FrameReader::get_default_max_frame_size()
+	{
+		return 64 * 1024 * 1024;
+	}
+
+	bool FrameReader::failed() const
+	{
+		return state_ == READ_ERROR;
+	}
+
+	void FrameReader::releaseReadingFrame()
+	{
+		if (reading_frame_) {
+			if (frame_pool_)
+				frame_pool_->release(reading_frame_);
+			else
+				delete reading_frame_;
+			reading_frame_ = NULL;
+		}
 	}
 
 	void FrameReader::reset()
 	{
 		state_ = READ_HEADERS;
 		line_buffer_.clear();
-		reading_frame_.reset();
+		releaseReadingFrame();
 		line_buffer_.reserve(1024);
-		reading_content_length_ = 0;
+		reading_content_length_ = -1;
+		streaming_ = false;
+		streamed_length_ = 0;
 	}
 
 	/*
@@ -55,64 +119,201 @@ namespace stomp {
 	 */
 	bool FrameReader::ReadContext::read_header_line()
 	{
-		while (remaining()) {
-			char c = read_char();
-			if (c == '\n')
-				return true;
-			else
-				reader_->line_buffer_.push_back(c);
+		const char* begin = current_ptr();
+		const char* end = begin + remaining();
+		const char* eol = Scanner::find_byte(begin, end, '\n');
+		reader_->line_buffer_.append(begin, eol - begin);
+		if (eol == end) {
+			read_pos_ = length_;
+			return false;
 		}
-		return false;
+		read_pos_ += (int)(eol - begin) + 1;
+		return true;
 	}
 
-	bool FrameReader::parseAddHeader(Frame *frame, char* text)
+	/*
+	 * Splits at the first ':' like tryDecodeView, so a frame decodes to the same
+	 * headers whether it arrived whole or split; a line without ':' is a name
+	 * with an empty value.
+	 */
+	void FrameReader::parseAddHeader(Frame *frame, char* text, size_t length)
 	{
-		char* value = NULL;
-		char* key = strtok_s(text, ":", &value);
-		if (!key || !value)
-			return false;
-		frame->header(key, Frame::header_decode(value));
-		return true;
+		char* end = text + length;
+		char* colon = text + (Scanner::find_byte(text, end, ':') - text);
+		char* value = (colon != end) ? colon + 1 : end;
+		size_t key_length = Frame::header_decode_inplace(text, colon - text);
+		size_t value_length = Frame::header_decode_inplace(value, end - value);
+		frame->header(text, key_length, value, value_length);
+	}
+
+	/*
+	 * Decodes one whole frame starting at buffer into view_ without copying.
+	 * @return Consumed bytes if a frame was decoded, 0 if the frame is incomplete
+	 *         or otherwise needs the buffered path.
+	 */
+	int FrameReader::tryDecodeView(const char* buffer, int len)
+	{
+		const char* end = buffer + len;
+		const char* cur = buffer;
+		const char* eol;
+		const char* line_end;
+		const char* nul;
+
+		view_.clear();
+
+		eol = Scanner::find_byte(cur, end, '\n');
+		if (eol == end)
+			return 0;
+		line_end = eol;
+		while ((line_end > cur) && (line_end[-1] == '\r'))
+			line_end--;
+		if (line_end == cur) {
+			// Heartbeat
+			return 0;
+		}
+		view_.command_ = StringRef(cur, line_end - cur);
+		view_.command_id_ = Frame::command_id(cur, line_end - cur);
+		cur = eol + 1;
+
+		for (;;) {
+			const char* colon;
+			FrameView::HeaderRef header;
+
+			eol = Scanner::find_byte(cur, end, '\n');
+			if (eol == end)
+				return 0;
+			line_end = eol;
+			while ((line_end > cur) && ((line_end[-1] == '\r') || (line_end[-1] == ' ')))
+				line_end--;
+			if (line_end == cur) {
+				cur = eol + 1;
+				break;
+			}
+			if (max_frame_size_ && ((size_t)(eol - cur) > max_frame_size_))
+				return 0;
+			if (Scanner::find_byte(cur, line_end, '\\') != line_end) {
+				// Escaped header, needs Frame::header_decode
+				return 0;
+			}
+			colon = Scanner::find_byte(cur, line_end, ':');
+			if (colon != line_end) {
+				header.name = StringRef(cur, colon - cur);
+				header.value = StringRef(colon + 1, line_end - colon - 1);
+			}
+			else {
+				header.name = StringRef(cur, line_end - cur);
+			}
+			view_.headers_.push_back(header);
+			cur = eol + 1;
+		}
+
+		if (view_.has_header(Frame::Headers::CONTENT_LENGTH) && (view_.contentLength() >= 0)) {
+			// Binary safe body, only the trailing NUL is checked
+			int content_length = view_.contentLength();
+			if ((streaming_threshold_ > 0) && (content_length > streaming_threshold_)
+				&& (view_.command_id() == Frame::COMMAND_MESSAGE))
+				return 0;
+			// Refused by the buffered path
+			if (max_frame_size_ && ((size_t)content_length > max_frame_size_))
+				return 0;
+			if ((end - cur) <= content_length)
+				return 0;
+			nul = cur + content_length;
+			if (*nul != 0)
+				return 0;
+		}
+		else {
+			nul = Scanner::find_byte(cur, end, 0);
+			if ((nul == end) || (max_frame_size_ && ((size_t)(nul - cur) > max_frame_size_)))
+				return 0;
+		}
+		view_.body_ = StringRef(cur, nul - cur);
+
+		return (int)(nul + 1 - buffer);
 	}
 
 	int FrameReader::decode(const char* buffer, int len, std::list< std::unique_ptr<Frame> >& out)
+	{
+		FrameListHandler handler(out);
+		return decode(buffer, len, &handler);
+	}
+
+	int FrameReader::decode(const char* buffer, int len, FrameHandler* handler)
 	{
 		ReadContext read_context(this, buffer, len);
+		bool complete;
+		int rc = 0;
 
 		while (read_context.remaining()) {
+			if (state_ == READ_ERROR)
+				break;
+			if ((state_ == READ_HEADERS) && !reading_frame_ && line_buffer_.empty()) {
+				int view_length = tryDecodeView(read_context.current_ptr(), read_context.remaining());
+				if (view_length > 0) {
+					rc = handler->onFrameView(view_);
+					read_context.read_pos_ += view_length;
+					continue;
+				}
+			}
+
 			switch (state_)
 			{
 			case READ_HEADERS:
-				if (read_context.read_header_line())
+				complete = read_context.read_header_line();
+				if (max_frame_size_ && (line_buffer_.size() > max_frame_size_)) {
+					state_ = READ_ERROR;
+					break;
+				}
+				if (complete)
 				{
 					do {
-						if (reading_frame_.get()) {
+						if (reading_frame_) {
 							int line_length = line_buffer_.size();
 							if (!line_buffer_.empty()) {
 								line_length = trim_end_type2(&line_buffer_[0]);
 							}
 							if (line_length > 0) {
-								parseAddHeader(reading_frame_.get(), &line_buffer_[0]);
+								parseAddHeader(reading_frame_, &line_buffer_[0], line_length);
 							}
 							else {
-								if (reading_frame_->has_header(Frame::Headers::CONTENT_LENGTH)) {
+								if (reading_frame_->has_header(Frame::HEADER_CONTENT_LENGTH)) {
 									reading_content_length_ = reading_frame_->contentLength();
 									if (reading_content_length_ == 0) {
 										state_ = READ_EOF;
 										break;
 									}
+									if ((streaming_threshold_ > 0) && (reading_content_length_ > streaming_threshold_)
+										&& (reading_frame_->command_id() == Frame::COMMAND_MESSAGE)) {
+										streaming_ = true;
+										rc = handler->onFrameHeaders(reading_frame_);
+									}
+									else if (reading_content_length_ > 0) {
+										if (max_frame_size_ && ((size_t)reading_content_length_ > max_frame_size_)) {
+											state_ = READ_ERROR;
+											break;
+										}
+										// Only what has arrived: the length comes from the peer
+										reading_frame_->refValue().reserve((reading_content_length_ < read_context.remaining()) ? reading_content_length_ : read_context.remaining());
+									}
 								}
 								state_ = READ_CONTENT;
 							}
 						}
 						else {
+							while (!line_buffer_.empty() && (line_buffer_[line_buffer_.size() - 1] == '\r'))
+								line_buffer_.resize(line_buffer_.size() - 1);
 							if (line_buffer_.empty()) {
 								// Heartbeat
-								printf("HEARTBEAT RECEVIVE\n");
 								reset();
 							}
 							else {
-								reading_frame_.reset(new Frame(line_buffer_));
+								if (frame_pool_) {
+									reading_frame_ = frame_pool_->acquire();
+									reading_frame_->command(line_buffer_);
+								}
+								else {
+									reading_frame_ = new Frame(line_buffer_);
+								}
 							}
 						}
 					} while (false);
@@ -120,29 +321,55 @@ namespace stomp {
 				}
 				break;
 			case READ_CONTENT:
-				do {
-					int buf_remaining = read_context.remaining();
-					int readable_length = my_strlen_s(read_context.current_ptr(), buf_remaining);
-					line_buffer_.append(read_context.current_ptr(), readable_length);
+				if (streaming_) {
+					int readable_length = reading_content_length_ - streamed_length_;
+					if (readable_length > read_context.remaining())
+						readable_length = read_context.remaining();
+					streamed_length_ += readable_length;
+					rc = handler->onFrameChunk(reading_frame_, read_context.current_ptr(), readable_length, streamed_length_ == reading_content_length_);
 					read_context.read_pos_ += readable_length;
-					if (readable_length < buf_remaining) {
+					if (streamed_length_ == reading_content_length_) {
 						state_ = READ_EOF;
 					}
-				} while (false);
+				}
+				else if (reading_content_length_ >= 0) {
+					std::string& body = reading_frame_->refValue();
+					int readable_length = reading_content_length_ - (int)body.size();
+					if (readable_length > read_context.remaining())
+						readable_length = read_context.remaining();
+					body.append(read_context.current_ptr(), readable_length);
+					read_context.read_pos_ += readable_length;
+					if ((int)body.size() == reading_content_length_) {
+						state_ = READ_EOF;
+					}
+				}
+				else {
+					const char* begin = read_context.current_ptr();
+					const char* end = begin + read_context.remaining();
+					const char* nul = Scanner::find_byte(begin, end, 0);
+					reading_frame_->refValue().append(begin, nul - begin);
+					read_context.read_pos_ += (int)(nul - begin);
+					if (max_frame_size_ && (reading_frame_->body().size() > max_frame_size_)) {
+						state_ = READ_ERROR;
+					}
+					else if (nul != end) {
+						state_ = READ_EOF;
+					}
+				}
 				break;
 			case READ_EOF:
 				if (read_context.read_char() == 0)
 				{
-					reading_frame_->body(line_buffer_);
-					out.emplace_back(std::move(reading_frame_));
-					reading_frame_.reset();
+					if (!streaming_)
+						rc = handler->onFrame(reading_frame_);
 					reset();
 				}
 				break;
 			}
 		}
-		return 0;
+		if (state_ == READ_ERROR)
+			return -1;
+		return rc;
 	}
 
 } // namespace stomp
-
@@ -12,15 +12,79 @@
 #include <memory>
 
 #include "frame.hpp"
+#include "frame_view.hpp"
+#include "frame_pool.hpp"
 
 namespace stomp {
 
+	class FrameHandler {
+	public:
+		virtual ~FrameHandler() {}
+
+		/**
+		 * Called with an owning frame when the frame was not fully contained in
+		 * one decode() buffer. The frame is only valid during the call.
+		 */
+		virtual int onFrame(Frame* frame) = 0;
+
+		/**
+		 * Called with a zero-copy view when the whole frame was contained in one
+		 * decode() buffer. The default implementation materializes a Frame.
+		 */
+		virtual int onFrameView(const FrameView& view) {
+			Frame frame;
+			view.to_frame(frame);
+			return onFrame(&frame);
+		}
+
+		/**
+		 * Streaming mode: called when the headers of a MESSAGE frame whose
+		 * content-length exceeds the streaming threshold have been read. The body
+		 * stays empty.
+		 */
+		virtual int onFrameHeaders(Frame* frame) {
+			return 0;
+		}
+
+		/**
+		 * Streaming mode: called with each part of the body, straight from the
+		 * decode() buffer. is_last is set on the part that completes content-length.
+		 */
+		virtual int onFrameChunk(Frame* frame, const char* data, int len, bool is_last) {
+			return 0;
+		}
+	};
+
+	/**
+	 * Adapts a callable sink to FrameHandler.
+	 * The sink must accept both Frame* and const FrameView& and return int.
+	 */
+	template<typename Sink>
+	class FrameSinkHandler : public FrameHandler {
+	private:
+		Sink& sink_;
+
+	public:
+		FrameSinkHandler(Sink& sink)
+			: sink_(sink) {}
+
+		int onFrame(Frame* frame) override {
+			return sink_(frame);
+		}
+
+		int onFrameView(const FrameView& view) override {
+			return sink_(view);
+		}
+	};
+
 	class FrameReader {
 	private:
 		enum State {
 			READ_HEADERS,
 			READ_CONTENT,
-			READ_EOF
+			READ_EOF,
+			// Frame over max_frame_size_, until reset()
+			READ_ERROR
 		};
 
 		struct ReadContext {
@@ -57,14 +121,68 @@ namespace stomp {
 
 		State state_;
 		std::string line_buffer_;
-		std::unique_ptr<Frame> reading_frame_;
+		Frame* reading_frame_;
 		int reading_content_length_;
 
-		bool parseAddHeader(Frame* frame, char* text);
+		int streaming_threshold_;
+		size_t max_frame_size_;
+		bool streaming_;
+		int streamed_length_;
+
+		FrameView view_;
+		FramePool* frame_pool_;
+
+		FrameReader(const FrameReader& o);
+		FrameReader& operator=(const FrameReader& o);
+
+		void parseAddHeader(Frame* frame, char* text, size_t length);
+		int tryDecodeView(const char* buffer, int len);
+		void releaseReadingFrame();
 
 	public:
+		FrameReader();
+		~FrameReader();
+
+		/**
+		 * Frames for the buffered path are taken from and returned to pool.
+		 * The pool must outlive the reader. NULL uses new / delete.
+		 */
+		void set_frame_pool(FramePool* pool);
+
+		/**
+		 * MESSAGE frames with a content-length above threshold bytes are delivered
+		 * through FrameHandler::onFrameHeaders and onFrameChunk instead of being
+		 * buffered; other frames, e.g. ERROR, are always buffered. 0 (default)
+		 * disables streaming.
+		 */
+		void set_streaming_threshold(int threshold);
+
+		/**
+		 * Limit on a buffered body (by content-length or up to its NUL) and on a
+		 * header line; streamed bodies are not limited. A frame over it is a
+		 * protocol error: decode() returns -1 and failed() holds until reset().
+		 * 0 disables the limit, the default is get_default_max_frame_size().
+		 */
+		void set_max_frame_size(size_t bytes);
+		static size_t get_default_max_frame_size();
+		/**
+		 * @return true after a protocol error; the connection should be closed.
+		 */
+		bool failed() const;
+
 		void reset();
 		int decode(const char* buffer, int len, std::list< std::unique_ptr<Frame> >& out);
+		int decode(const char* buffer, int len, FrameHandler* handler);
+
+		/**
+		 * Calls sink as each frame completes, with a FrameView when the frame was
+		 * contained in buffer and a Frame* otherwise. Both are only valid during the call.
+		 */
+		template<typename Sink>
+		int decode_each(const char* buffer, int len, Sink& sink) {
+			FrameSinkHandler<Sink> handler(sink);
+			return decode(buffer, len, &handler);
+		}
 	};
 }
 
@@ -0,0 +1,104 @@
+/**
+ * @file	frame_view.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "frame_view.hpp"
+
+namespace stomp {
+
+	FrameView::FrameView()
+		: command_id_(Frame::COMMAND_UNKNOWN)
+	{
+		headers_.reserve(16);
+	}
+
+	void FrameView::clear()
+	{
+		command_ = StringRef();
+		command_id_ = Frame::COMMAND_UNKNOWN;
+		headers_.clear();
+		body_ = StringRef();
+	}
+
+	const StringRef& FrameView::command() const {
+		return command_;
+	}
+
+	Frame::CommandId FrameView::command_id() const {
+		return command_id_;
+	}
+
+	size_t FrameView::header_count() const {
+		return headers_.size();
+	}
+
+	const FrameView::HeaderRef& FrameView::header_at(size_t index) const {
+		return headers_[index];
+	}
+
+	StringRef FrameView::header(const StringRef& name) const {
+		// First occurrence wins, as with Frame::header
+		for (std::vector<HeaderRef>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++) {
+			if (iter->name.equals_ignore_case(name))
+				return iter->value;
+		}
+		return StringRef();
+	}
+
+	bool FrameView::has_header(const StringRef& name) const {
+		for (std::vector<HeaderRef>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++) {
+			if (iter->name.equals_ignore_case(name))
+				return true;
+		}
+		return false;
+	}
+
+	const StringRef& FrameView::body() const {
+		return body_;
+	}
+
+	StringRef FrameView::destination() const {
+		return header("destination");
+	}
+
+	StringRef FrameView::contentType() const {
+		return header("content-type");
+	}
+
+	StringRef FrameView::subscription() const {
+		return header("subscription");
+	}
+
+	StringRef FrameView::messageId() const {
+		return header("message-id");
+	}
+
+	int FrameView::contentLength() const {
+		StringRef value = header("content-length");
+		int result = 0;
+		size_t i = 0;
+		bool negative = false;
+		if (value.empty())
+			return body_.size();
+		while ((i < value.size()) && (value[i] == ' '))
+			i++;
+		if ((i < value.size()) && ((value[i] == '-') || (value[i] == '+')))
+			negative = (value[i++] == '-');
+		for (; (i < value.size()) && (value[i] >= '0') && (value[i] <= '9'); i++)
+			result = result * 10 + (value[i] - '0');
+		return negative ? -result : result;
+	}
+
+	void FrameView::to_frame(Frame& frame) const {
+		frame.command(command_.to_string());
+		for (std::vector<HeaderRef>::const_iterator iter = headers_.begin(); iter != headers_.end(); iter++) {
+			frame.header(iter->name.data(), iter->name.size(), iter->value.data(), iter->value.size());
+		}
+		frame.refValue().assign(body_.data(), body_.size());
+	}
+
+}
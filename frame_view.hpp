@@ -0,0 +1,63 @@
+/**
+ * @file	frame_view.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <vector>
+
+#include "string_ref.hpp"
+#include "frame.hpp"
+
+namespace stomp {
+
+	class FrameReader;
+
+	/**
+	 * Zero-copy view of a decoded frame.
+	 * Command, header and body slices point into the receive buffer passed to
+	 * FrameReader::decode and are only valid during the handler callback.
+	 * Header values are never escaped (FrameReader falls back to Frame otherwise).
+	 */
+	class FrameView {
+	public:
+		struct HeaderRef {
+			StringRef name;
+			StringRef value;
+		};
+
+	private:
+		friend class FrameReader;
+
+		StringRef command_;
+		Frame::CommandId command_id_;
+		std::vector<HeaderRef> headers_;
+		StringRef body_;
+
+	public:
+		FrameView();
+
+		void clear();
+
+		const StringRef& command() const;
+		Frame::CommandId command_id() const;
+		size_t header_count() const;
+		const HeaderRef& header_at(size_t index) const;
+		StringRef header(const StringRef& name) const;
+		bool has_header(const StringRef& name) const;
+		const StringRef& body() const;
+
+		StringRef destination() const;
+		StringRef contentType() const;
+		StringRef subscription() const;
+		StringRef messageId() const;
+		int contentLength() const;
+
+		void to_frame(Frame& frame) const;
+	};
+
+}
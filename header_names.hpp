@@ -0,0 +1,104 @@
+/**
+ * @file	header_names.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace stomp {
+
+	/**
+	 * Compile-time table of the well-known STOMP header names.
+	 * Entries are in Frame::HeaderId order.
+	 */
+	namespace header_names {
+
+		constexpr const char* const names[] = {
+			"destination",
+			"id",
+			"ack",
+			"receipt",
+			"receipt-id",
+			"message-id",
+			"subscription",
+			"content-length",
+			"content-type",
+			"transaction",
+			"heart-beat",
+			"accept-version",
+			"version",
+			"host",
+			"login",
+			"passcode",
+			"server",
+			"session",
+			"message"
+		};
+
+		constexpr int count = sizeof(names) / sizeof(names[0]);
+
+		// Perfect hash: slot = (hash * SEED) >> (32 - SLOT_BITS), verified below
+		constexpr uint32_t SEED = 697;
+		constexpr int SLOT_BITS = 5;
+		constexpr int SLOT_COUNT = 1 << SLOT_BITS;
+
+		constexpr char ascii_lower(char c) {
+			return ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+		}
+
+		constexpr size_t length(const char* text) {
+			return *text ? 1 + length(text + 1) : 0;
+		}
+
+		/**
+		 * Case-insensitive FNV-1a, usable at compile time and on unterminated input.
+		 */
+		constexpr uint32_t hash(const char* text, size_t len, uint32_t value = 2166136261u) {
+			return (len == 0) ? value : hash(text + 1, len - 1, (uint32_t)((value ^ (uint32_t)(unsigned char)ascii_lower(*text)) * 16777619u));
+		}
+
+		/**
+		 * hash() as a loop, for names read off the wire: the recursive form is
+		 * one call per character when the compiler does not fold it.
+		 */
+		inline uint32_t runtime_hash(const char* text, size_t len) {
+			uint32_t value = 2166136261u;
+			for (size_t i = 0; i < len; i++)
+				value = (value ^ (uint32_t)(unsigned char)ascii_lower(text[i])) * 16777619u;
+			return value;
+		}
+
+		constexpr int slot_of_hash(uint32_t value) {
+			return (int)((uint32_t)(value * SEED) >> (32 - SLOT_BITS));
+		}
+
+		constexpr int slot_of(int id) {
+			return slot_of_hash(hash(names[id], length(names[id])));
+		}
+
+		constexpr bool distinct_from(int id, int other) {
+			return (other >= count) ? true : ((slot_of(id) != slot_of(other)) && distinct_from(id, other + 1));
+		}
+
+		constexpr bool is_perfect(int id = 0) {
+			return (id >= count) ? true : (distinct_from(id, id + 1) && is_perfect(id + 1));
+		}
+
+		static_assert(is_perfect(), "header_names::SEED does not give a perfect hash, pick another one");
+
+		/**
+		 * @return Index into names for slot, or -1 if the slot is empty.
+		 */
+		constexpr int id_of_slot(int slot, int id = 0) {
+			return (id >= count) ? -1 : ((slot_of(id) == slot) ? id : id_of_slot(slot, id + 1));
+		}
+
+	}
+
+}
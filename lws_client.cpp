@@ -15,6 +15,7 @@
 #include "frame.hpp"
 
 #include "command/connect.hpp"
+#include "command/prepared_send.hpp"
 
 #if !defined(_MSC_VER) || !_MSC_VER
 #define strtok_s strtok_r
@@ -22,23 +23,55 @@
 
 namespace stomp {
 
-	LibwebsocketsClient::LibwebsocketsClient(bool use_lws_timer)
+	LibwebsocketsClient::LibwebsocketsClient(bool use_lws_timer, MemoryResource* resource)
 		: Client(),
 		use_lws_timer_(use_lws_timer),
 		wsi_(NULL),
+		context_(NULL),
+		wake_pending_(false),
 		state_(State::DISCONNECTED),
+		memory_resource_(resource ? resource : MemoryResource::new_delete()),
+		frame_pool_(16, memory_resource_),
+		receive_handler_(this),
+		dispatcher_(NULL),
+		dispatch_pending_(0),
+		send_queue_count_(0),
+		send_queue_bytes_(0),
+		send_queue_since_(0),
+		send_queue_max_bytes_(0),
+		send_queue_max_frames_(0),
+		send_queue_low_bytes_(0),
+		send_queue_low_frames_(0),
+		send_queue_refused_(false),
+		send_space_waiters_(0),
+		close_count_(0),
+		write_coalesce_bytes_(0),
+		write_linger_us_(0),
 		id_tx_count_(0),
 		id_sub_count_(0),
 		heartbeat_cx_(10000),
 		heartbeat_cy_(10000),
 		heartbeat_sx_(0),
 		heartbeat_sy_(0),
-		heartbeat_send_interval_(0)
+		heartbeat_send_interval_(0),
+		heartbeat_receive_interval_(0),
+		timer_wheel_(NULL),
+		heartbeat_send_timer_(this, false),
+		heartbeat_receive_timer_(this, true)
 	{
+		frame_reader_.set_frame_pool(&frame_pool_);
+		send_pool_.reserve(get_send_buffer_pool_size());
 	}
 
 	LibwebsocketsClient::~LibwebsocketsClient()
 	{
+		LwsMessageBuffer* item;
+		// Pooled frames and the receive handler must outlive the posted frames
+		waitDispatched();
+		while ((item = send_queue_.pop()) != NULL)
+			delete item;
+		for (std::vector<MessageVectorBuffer*>::iterator iter = send_pool_.begin(); iter != send_pool_.end(); iter++)
+			delete *iter;
 	}
 
 	int LibwebsocketsClient::callbackProtocol(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len, bool* processed)
@@ -48,19 +81,34 @@ namespace stomp {
 		switch (reason) {
 		case LWS_CALLBACK_WSI_CREATE:
 			wsi_ = wsi;
+			context_.store(lws_get_context(wsi));
 			break;
 
 		case LWS_CALLBACK_WSI_DESTROY:
+			context_.store(NULL);
 			wsi_ = NULL;
 			break;
 
+		case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
+			// lws_cancel_service() from wakeService(); cleared before the queue
+			// check so a send racing with it wakes the loop again
+			wake_pending_.store(false);
+			if (wsi_ && (writing_buffer_ || (send_queue_count_.load() > 0)))
+				lws_callback_on_writable(wsi_);
+			break;
+
 		case LWS_CALLBACK_CLIENT_ESTABLISHED:
-			if (use_lws_timer_)
-				lws_set_timer_usecs(wsi, 100000);
+			// Same test as LWS_CALLBACK_TIMER: the wheel created by startHeartbeat
+			// is still set on a reconnect and needs the timer as well
+			if (use_lws_timer_ && (own_timer_wheel_ || !timer_wheel_))
+				lws_set_timer_usecs(wsi, get_timer_period_us());
 			sendConnectFrame();
 			*processed = true;
 			break;
 
+		case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+			// The connect failed: no CLIENT_CLOSED follows, so wake blocked
+			// senders and fail receipts here
 		case LWS_CALLBACK_CLIENT_CLOSED:
 			rc = onSocketClosed();
 			*processed = true;
@@ -84,7 +132,9 @@ namespace stomp {
 			if (use_lws_timer_)
 			{
 				timerProc();
-				lws_set_timer_usecs(wsi, 100000);
+				// With a shared wheel this only fires for write linger
+				if (own_timer_wheel_ || !timer_wheel_)
+					lws_set_timer_usecs(wsi, get_timer_period_us());
 			}
 			break;
 
@@ -99,79 +149,578 @@ namespace stomp {
 	{
 		bool sendable;
 
-		if (heartbeat_send_interval_ > 0 && state_ == State::CONNECTED) {
-			std::chrono::steady_clock::time_point cur = std::chrono::steady_clock::now();
-			std::chrono::steady_clock::duration diff = cur - heartbeat_prev_ticks_;
-
-			if (diff >= std::chrono::milliseconds(heartbeat_send_interval_))
-			{
-				// Send heartbeat
-				std::unique_ptr<MessageVectorBuffer> item(new MessageVectorBuffer());
-				std::unique_ptr<MessageBuffer> temp;
-				item->writePrepare().push_back('\n');
-				item->writeDone();
-				temp = std::move(item);
-				pushSendData(temp);
-				heartbeat_prev_ticks_ = cur;
-			}
-		}
+		if (own_timer_wheel_)
+			own_timer_wheel_->advance(std::chrono::steady_clock::now());
 
-		send_queue_lock_.lock();
-		sendable = send_queue_data_.empty();
-		send_queue_lock_.unlock();
+		if (!wsi_)
+			return;
+		sendable = (send_queue_count_.load(std::memory_order_acquire) == 0) && !writing_buffer_;
 		if (!sendable)
 			lws_callback_on_writable(wsi_);
 	}
 
-	void LibwebsocketsClient::pushSendData(std::unique_ptr<MessageBuffer>& item)
+	void LibwebsocketsClient::pushSendData(std::unique_ptr<LwsMessageBuffer>& item)
 	{
-		std::unique_lock<std::mutex> lock(send_queue_lock_);
-		send_queue_data_.emplace_back(std::move(item));
+		queueSendData(item);
 		lws_callback_on_writable(wsi_);
 	}
 
+	/*
+	 * @param bounded Refuse the item if it would exceed the send queue limits.
+	 * @return SEND_OK, or SEND_QUEUE_FULL (the item is recycled).
+	 */
+	int LibwebsocketsClient::queueSendData(std::unique_ptr<LwsMessageBuffer>& item, bool bounded)
+	{
+		size_t size = item->queued_size();
+		// Reserved before the push so the consumer never sees more items than the counters
+		size_t bytes = send_queue_bytes_.fetch_add(size) + size;
+		size_t frames = send_queue_count_.fetch_add(1) + 1;
+		if (bounded && sendQueueOver(bytes, frames, size)) {
+			send_queue_bytes_.fetch_sub(size);
+			send_queue_count_.fetch_sub(1);
+			send_queue_refused_.store(true);
+			recycleSendBuffer(item);
+			return SEND_QUEUE_FULL;
+		}
+		if (frames == 1)
+			send_queue_since_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+		send_queue_.push(item.release());
+		return SEND_OK;
+	}
+
+	/*
+	 * Called from application threads after queueing: lws_callback_on_writable
+	 * is only safe on the service thread, so interrupt its poll instead.
+	 * One lws_cancel_service per service loop turn is enough.
+	 */
+	void LibwebsocketsClient::wakeService()
+	{
+		struct lws_context* context = context_.load();
+		if (context && !wake_pending_.exchange(true))
+			lws_cancel_service(context);
+	}
+
+	/*
+	 * @param bytes, frames Queue totals including the incoming item.
+	 */
+	bool LibwebsocketsClient::sendQueueOver(size_t bytes, size_t frames, size_t incoming) const
+	{
+		if (send_queue_max_frames_ && (frames > send_queue_max_frames_))
+			return true;
+		// An oversized item still goes into an empty queue, or it could never be sent
+		if (send_queue_max_bytes_ && (bytes > send_queue_max_bytes_) && (bytes != incoming))
+			return true;
+		return false;
+	}
+
+	/*
+	 * Service thread, after buffers left the queue.
+	 */
+	void LibwebsocketsClient::onSendQueueTaken()
+	{
+		if (send_space_waiters_.load() > 0) {
+			std::unique_lock<std::mutex> lock(send_space_lock_);
+			send_space_cond_.notify_all();
+		}
+		if (send_queue_refused_.load(std::memory_order_relaxed)
+			&& (send_queue_bytes_.load() <= send_queue_low_bytes_)
+			&& (send_queue_count_.load() <= send_queue_low_frames_)) {
+			send_queue_refused_.store(false);
+			onSendQueueLow();
+		}
+	}
+
+	/*
+	 * Service thread only: discards everything queued or half written, so
+	 * nothing of a closed connection is written to the next one.
+	 */
+	void LibwebsocketsClient::dropSendData()
+	{
+		std::unique_ptr<LwsMessageBuffer> item;
+		recycleSendBuffer(writing_buffer_);
+		for (size_t i = 0; i < coalesce_items_.size(); i++)
+			recycleSendBuffer(coalesce_items_[i]);
+		coalesce_items_.clear();
+		while (peekSendData()) {
+			takeSendData(item);
+			recycleSendBuffer(item);
+		}
+	}
+
+	/*
+	 * Service thread only.
+	 * @return Next queued buffer without removing it, NULL if none is visible yet.
+	 */
+	LibwebsocketsClient::LwsMessageBuffer* LibwebsocketsClient::peekSendData()
+	{
+		if (!send_queue_front_) {
+			LwsMessageBuffer* item = send_queue_.pop();
+			if (!item)
+				return NULL;
+			send_queue_front_.reset(item);
+		}
+		return send_queue_front_.get();
+	}
+
+	/*
+	 * Service thread only, after peekSendData() returned a buffer.
+	 */
+	void LibwebsocketsClient::takeSendData(std::unique_ptr<LwsMessageBuffer>& out)
+	{
+		out = std::move(send_queue_front_);
+		send_queue_bytes_.fetch_sub(out->queued_size());
+		send_queue_count_.fetch_sub(1);
+	}
+
+	/*
+	 * Called after peekSendData() returned a buffer.
+	 * @return Microseconds to hold back the write for more frames, 0 to write now.
+	 */
+	int LibwebsocketsClient::lingerRemainingUs() const
+	{
+		std::chrono::steady_clock::duration since(send_queue_since_.load(std::memory_order_relaxed));
+		int64_t elapsed_us;
+		if ((write_coalesce_bytes_ <= 0) || (write_linger_us_ <= 0))
+			return 0;
+		if ((send_queue_bytes_.load(std::memory_order_relaxed) >= (size_t)write_coalesce_bytes_) || !send_queue_front_->recyclable())
+			return 0;
+		elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch() - since).count();
+		if (elapsed_us >= write_linger_us_)
+			return 0;
+		return (int)(write_linger_us_ - elapsed_us);
+	}
+
+	/*
+	 * Copies writing_buffer_ and coalesce_items_ into one pooled buffer,
+	 * which becomes the new writing_buffer_.
+	 */
+	void LibwebsocketsClient::coalesceSendData(size_t total_size)
+	{
+		std::unique_ptr<MessageVectorBuffer> batch(acquireSendBuffer());
+		std::vector<char>& data = batch->writePrepare();
+		data.reserve(data.size() + total_size + get_send_buffer_post_padding());
+		data.insert(data.end(), writing_buffer_->data_ptr(), writing_buffer_->data_ptr() + writing_buffer_->data_size());
+		recycleSendBuffer(writing_buffer_);
+		for (size_t i = 0; i < coalesce_items_.size(); i++) {
+			std::unique_ptr<LwsMessageBuffer>& item = coalesce_items_[i];
+			data.insert(data.end(), item->data_ptr(), item->data_ptr() + item->data_size());
+			recycleSendBuffer(item);
+		}
+		coalesce_items_.clear();
+		batch->writeDone();
+		writing_buffer_ = std::move(batch);
+	}
+
+	std::unique_ptr<LibwebsocketsClient::MessageVectorBuffer> LibwebsocketsClient::acquireSendBuffer()
+	{
+		std::unique_lock<std::mutex> lock(send_pool_lock_);
+		if (!send_pool_.empty()) {
+			std::unique_ptr<MessageVectorBuffer> item(send_pool_.back());
+			send_pool_.pop_back();
+			return item;
+		}
+		lock.unlock();
+		return std::unique_ptr<MessageVectorBuffer>(new MessageVectorBuffer());
+	}
+
+	void LibwebsocketsClient::recycleSendBuffer(std::unique_ptr<LwsMessageBuffer>& item)
+	{
+		if (item && item->recyclable()) {
+			MessageVectorBuffer* buffer = static_cast<MessageVectorBuffer*>(item.get());
+			// Large one-off buffers are not worth keeping
+			if (buffer->capacity() <= (size_t)get_send_buffer_pool_max_capacity()) {
+				std::unique_lock<std::mutex> lock(send_pool_lock_);
+				if (send_pool_.size() < (size_t)get_send_buffer_pool_size()) {
+					send_pool_.push_back(buffer);
+					item.release();
+					return;
+				}
+			}
+		}
+		item.reset();
+	}
+
+	/*
+	 * Service thread, on LWS_CALLBACK_CLIENT_ESTABLISHED. CONNECT becomes the
+	 * writing buffer, ahead of frames queued while disconnected, which the
+	 * broker would otherwise see before CONNECT.
+	 */
 	void LibwebsocketsClient::sendConnectFrame()
 	{
-		std::unique_ptr<MessageVectorBuffer> item(new MessageVectorBuffer());
-		std::unique_ptr<MessageBuffer> temp;
+		std::unique_ptr<MessageVectorBuffer> item(acquireSendBuffer());
 		command::Connect connect(this);
 		connect.frame()->make_payload_append(item->writePrepare());
 		item->writeDone();
-		temp = std::move(item);
-		pushSendData(temp);
+		// Empty after onSocketClosed(); only a stale buffer could be here
+		recycleSendBuffer(writing_buffer_);
+		writing_buffer_ = std::move(item);
+		lws_callback_on_writable(wsi_);
 	}
 
 	int LibwebsocketsClient::onSocketWriteable(struct lws* wsi)
 	{
-		std::unique_lock<std::mutex> lock(send_queue_lock_);
-		if (!send_queue_data_.empty()) {
-			std::unique_ptr<MessageBuffer> buf(std::move(send_queue_data_.front()));
-			send_queue_data_.pop_front();
-			lock.unlock();
-			return lws_write(wsi_, (unsigned char*)buf->data_ptr(), buf->data_size(), LWS_WRITE_BINARY);
+		int rc;
+		bool pending;
+
+		if (!writing_buffer_) {
+			LwsMessageBuffer* next;
+			size_t total_size;
+			int linger_us;
+			if (!peekSendData())
+				return 0;
+			linger_us = lingerRemainingUs();
+			if (linger_us > 0) {
+				// Woken by the next send, or by the timer once linger expires
+				if (use_lws_timer_)
+					lws_set_timer_usecs(wsi_, linger_us);
+				return 0;
+			}
+			takeSendData(writing_buffer_);
+			total_size = writing_buffer_->data_size();
+			if ((write_coalesce_bytes_ > 0) && writing_buffer_->recyclable()) {
+				while (((next = peekSendData()) != NULL) && next->recyclable()) {
+					size_t size = next->data_size();
+					if (total_size + size > (size_t)write_coalesce_bytes_)
+						break;
+					total_size += size;
+					coalesce_items_.push_back(std::unique_ptr<LwsMessageBuffer>());
+					takeSendData(coalesce_items_.back());
+				}
+			}
+			if (!coalesce_items_.empty())
+				coalesceSendData(total_size);
+			onSendQueueTaken();
 		}
+
+		rc = writing_buffer_->write(wsi_);
+		if (rc <= 0)
+			recycleSendBuffer(writing_buffer_);
+		if (rc < 0)
+			return rc;
+		// Any written frame counts as a heart-beat
+		heartbeat_prev_ticks_ = std::chrono::steady_clock::now();
+
+		pending = writing_buffer_ || (send_queue_count_.load(std::memory_order_acquire) > 0);
+		if (pending)
+			lws_callback_on_writable(wsi_);
 		return 0;
 	}
 
-	int LibwebsocketsClient::onSocketReceive(struct lws* wsi, const char* data, int len)
+	int LibwebsocketsClient::LwsMessageBuffer::write(struct lws* wsi)
+	{
+		if (lws_write(wsi, (unsigned char*)data_ptr(), data_size(), LWS_WRITE_BINARY) < 0)
+			return -1;
+		return 0;
+	}
+
+	LibwebsocketsClient::MessageFrameBuffer::MessageFrameBuffer(std::unique_ptr<Frame> frame)
+		: frame_(std::move(frame)), body_offset_(0), queued_size_(0), head_sent_(false)
+	{
+		const std::string& body = frame_->body();
+		std::vector<char>& head = head_.writePrepare();
+		size_t inline_size = get_send_buffer_pre_padding();
+
+		if (inline_size > body.size())
+			inline_size = body.size();
+		head.reserve(head.size() + frame_->header_block_size() + inline_size + 1 + get_send_buffer_post_padding());
+		frame_->make_header_block_append(head);
+		head.insert(head.end(), body.begin(), body.begin() + inline_size);
+		body_offset_ = inline_size;
+		if (body_offset_ == body.size())
+			head.push_back(0);
+		head_.writeDone();
+
+		trailer_.writePrepare().push_back(0);
+		trailer_.writeDone();
+
+		queued_size_ = head_.data_size() + (body.size() - body_offset_) + trailer_.data_size();
+	}
+
+	int LibwebsocketsClient::MessageFrameBuffer::write(struct lws* wsi)
 	{
-		std::list< std::unique_ptr<Frame> > frames;
-		int rc = frame_reader_.decode(data, len, frames);
-		for (std::list< std::unique_ptr<Frame> >::iterator iter = frames.begin(); iter != frames.end(); iter++) {
-			const std::string& command = (*iter)->command();
-			if (command == Frame::Commands::CONNECTED)
-				rc = onFrameConnected(iter->get());
-			else if (command == Frame::Commands::MESSAGE)
-				rc = onMessage(iter->get());
+		std::string& body = frame_->refValue();
+		size_t length;
+
+		if (!head_sent_) {
+			bool complete = (body_offset_ == body.size());
+			head_sent_ = true;
+			if (lws_write(wsi, (unsigned char*)head_.data_ptr(), head_.data_size(), (enum lws_write_protocol)(LWS_WRITE_BINARY | (complete ? 0 : LWS_WRITE_NO_FIN))) < 0)
+				return -1;
+			return complete ? 0 : 1;
+		}
+
+		if (body_offset_ == body.size()) {
+			if (lws_write(wsi, (unsigned char*)trailer_.data_ptr(), trailer_.data_size(), LWS_WRITE_CONTINUATION) < 0)
+				return -1;
+			return 0;
 		}
+
+		// The pre-padding bytes in front of this fragment were already sent,
+		// so lws may overwrite them. The body is owned by this buffer.
+		length = body.size() - body_offset_;
+		if (length > (size_t)get_send_fragment_size())
+			length = get_send_fragment_size();
+		if (lws_write(wsi, (unsigned char*)&body[body_offset_], length, (enum lws_write_protocol)(LWS_WRITE_CONTINUATION | LWS_WRITE_NO_FIN)) < 0)
+			return -1;
+		body_offset_ += length;
+		return 1;
+	}
+
+	int LibwebsocketsClient::onSocketReceive(struct lws* wsi, const char* data, int len)
+	{
+		int rc;
+		// Any received byte counts as a heart-beat
+		heartbeat_received_ticks_ = std::chrono::steady_clock::now();
+		rc = frame_reader_.decode(data, len, &receive_handler_);
+		// Oversized frame: nothing after it can be parsed
+		if (frame_reader_.failed())
+			lws_set_timeout(wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
 		return rc;
 	}
 
+	int LibwebsocketsClient::ReceiveHandler::onFrame(Frame* frame)
+	{
+		switch (frame->command_id()) {
+		case Frame::COMMAND_CONNECTED:
+			return client_->onFrameConnected(frame);
+		case Frame::COMMAND_MESSAGE:
+			client_->onMessageAck(frame->header(Frame::HEADER_ACK));
+			if (client_->dispatcher_) {
+				// Take the decoded frame over, the reader continues with an empty one
+				Frame* item = client_->frame_pool_.acquire();
+				item->swap(*frame);
+				client_->postMessage(item);
+				return 0;
+			}
+			return client_->dispatchMessage(frame);
+		case Frame::COMMAND_RECEIPT:
+			client_->receipts()->complete(frame->header(Frame::HEADER_RECEIPT_ID), ReceiptTable::RECEIPT_OK);
+			return 0;
+		case Frame::COMMAND_ERROR:
+			return client_->onFrameError(frame);
+		default:
+			return 0;
+		}
+	}
+
+	int LibwebsocketsClient::ReceiveHandler::onFrameView(const FrameView& view)
+	{
+		switch (view.command_id()) {
+		case Frame::COMMAND_MESSAGE:
+			client_->onMessageAck(view.header("ack"));
+			if (client_->dispatcher_) {
+				// The view does not outlive this call
+				Frame* item = client_->frame_pool_.acquire();
+				view.to_frame(*item);
+				client_->postMessage(item);
+				return 0;
+			}
+			return client_->dispatchMessageView(view);
+		case Frame::COMMAND_RECEIPT:
+			// Pipelined receipts are frequent: matched straight from the view
+			client_->receipts()->complete(view.header("receipt-id"), ReceiptTable::RECEIPT_OK);
+			return 0;
+		case Frame::COMMAND_CONNECTED:
+		case Frame::COMMAND_ERROR:
+			return FrameHandler::onFrameView(view);
+		default:
+			return 0;
+		}
+	}
+
+	int LibwebsocketsClient::ReceiveHandler::onFrameHeaders(Frame* frame)
+	{
+		if (frame->command_id() != Frame::COMMAND_MESSAGE)
+			return 0;
+		client_->onMessageAck(frame->header(Frame::HEADER_ACK));
+		if (!client_->subscriptions()->empty()) {
+			SubscriptionHandler* handler = client_->subscriptions()->find(frame->subscription());
+			if (handler)
+				return handler->onMessageStart(frame);
+		}
+		return client_->onMessageStart(frame);
+	}
+
+	int LibwebsocketsClient::ReceiveHandler::onFrameChunk(Frame* frame, const char* data, int len, bool is_last)
+	{
+		if (frame->command_id() != Frame::COMMAND_MESSAGE)
+			return 0;
+		if (!client_->subscriptions()->empty()) {
+			SubscriptionHandler* handler = client_->subscriptions()->find(frame->subscription());
+			if (handler)
+				return handler->onMessageChunk(data, len, is_last);
+		}
+		return client_->onMessageChunk(frame->subscription(), data, len, is_last);
+	}
+
+	void LibwebsocketsClient::ReceiveHandler::onDispatch(Frame* frame)
+	{
+		client_->dispatchMessage(frame);
+		client_->frame_pool_.release(frame);
+		if (client_->dispatch_pending_.fetch_sub(1) == 1) {
+			std::unique_lock<std::mutex> lock(client_->dispatch_lock_);
+			client_->dispatch_cond_.notify_all();
+		}
+	}
+
+	void LibwebsocketsClient::postMessage(Frame* frame)
+	{
+		const std::string& key = dispatch_key_header_.empty() ? frame->subscription() : frame->header(dispatch_key_header_);
+		dispatch_pending_.fetch_add(1);
+		dispatcher_->post(key, &receive_handler_, frame);
+	}
+
+	void LibwebsocketsClient::waitDispatched()
+	{
+		std::unique_lock<std::mutex> lock(dispatch_lock_);
+		while (dispatch_pending_.load())
+			dispatch_cond_.wait(lock);
+	}
+
+	void LibwebsocketsClient::setMessageDispatcher(MessageDispatcher* dispatcher, const std::string& key_header)
+	{
+		waitDispatched();
+		dispatcher_ = dispatcher;
+		dispatch_key_header_ = key_header;
+	}
+
+	void LibwebsocketsClient::setStreamingThreshold(int threshold)
+	{
+		frame_reader_.set_streaming_threshold(threshold);
+	}
+
+	void LibwebsocketsClient::setMaxFrameSize(size_t bytes)
+	{
+		frame_reader_.set_max_frame_size(bytes);
+	}
+
+	void LibwebsocketsClient::setWriteCoalescing(int max_bytes, int linger_us)
+	{
+		write_coalesce_bytes_ = max_bytes;
+		write_linger_us_ = linger_us;
+	}
+
+	void LibwebsocketsClient::setSendQueueLimits(size_t max_bytes, size_t max_frames, size_t low_water_bytes, size_t low_water_frames)
+	{
+		send_queue_max_bytes_ = max_bytes;
+		send_queue_max_frames_ = max_frames;
+		send_queue_low_bytes_ = low_water_bytes ? low_water_bytes : (max_bytes ? max_bytes / 2 : (size_t)-1);
+		send_queue_low_frames_ = low_water_frames ? low_water_frames : (max_frames ? max_frames / 2 : (size_t)-1);
+	}
+
+	size_t LibwebsocketsClient::sendQueueBytes() const
+	{
+		return send_queue_bytes_.load(std::memory_order_relaxed);
+	}
+
+	size_t LibwebsocketsClient::sendQueueFrames() const
+	{
+		return send_queue_count_.load(std::memory_order_relaxed);
+	}
+
 	int LibwebsocketsClient::onSocketClosed()
 	{
+		frame_reader_.reset();
+		stopHeartbeat();
+		state_ = State::DISCONNECTED;
+		close_count_.fetch_add(1);
+		dropSendData();
+		onSendQueueTaken();
+		receipts()->fail_all(ReceiptTable::RECEIPT_CLOSED);
 		return onClosed();
 	}
 
+	int LibwebsocketsClient::onFrameError(Frame* frame)
+	{
+		if (frame->has_header(Frame::HEADER_RECEIPT_ID))
+			receipts()->complete(frame->header(Frame::HEADER_RECEIPT_ID), ReceiptTable::RECEIPT_ERROR, frame->header(Frame::HEADER_MESSAGE));
+		return onError(frame);
+	}
+
+	void LibwebsocketsClient::setTimerWheel(TimerWheel* wheel)
+	{
+		stopHeartbeat();
+		own_timer_wheel_.reset();
+		timer_wheel_ = wheel;
+	}
+
+	void LibwebsocketsClient::startHeartbeat()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (!timer_wheel_) {
+			own_timer_wheel_.reset(new TimerWheel(std::chrono::microseconds(get_timer_period_us()), 64));
+			timer_wheel_ = own_timer_wheel_.get();
+		}
+		heartbeat_prev_ticks_ = now;
+		heartbeat_received_ticks_ = now;
+		if (heartbeat_send_interval_ > 0)
+			timer_wheel_->schedule(&heartbeat_send_timer_, now + std::chrono::milliseconds(heartbeat_send_interval_));
+		if (heartbeat_receive_interval_ > 0)
+			onHeartbeatReceiveTimer();
+	}
+
+	void LibwebsocketsClient::stopHeartbeat()
+	{
+		if (timer_wheel_) {
+			timer_wheel_->cancel(&heartbeat_send_timer_);
+			timer_wheel_->cancel(&heartbeat_receive_timer_);
+		}
+	}
+
+	void LibwebsocketsClient::HeartbeatTimer::onTimer()
+	{
+		if (receive_)
+			client_->onHeartbeatReceiveTimer();
+		else
+			client_->onHeartbeatSendTimer();
+	}
+
+	/*
+	 * Deadlines are checked lazily: traffic only moves the timestamps, the timer
+	 * re-arms itself from them when it fires.
+	 */
+	void LibwebsocketsClient::onHeartbeatSendTimer()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point due = heartbeat_prev_ticks_ + std::chrono::milliseconds(heartbeat_send_interval_);
+
+		if ((state_ != State::CONNECTED) || (heartbeat_send_interval_ <= 0))
+			return;
+
+		if (now >= due) {
+			std::unique_ptr<MessageVectorBuffer> item(acquireSendBuffer());
+			std::unique_ptr<LwsMessageBuffer> temp;
+			item->writePrepare().push_back('\n');
+			item->writeDone();
+			temp = std::move(item);
+			pushSendData(temp);
+			heartbeat_prev_ticks_ = now;
+			due = now + std::chrono::milliseconds(heartbeat_send_interval_);
+		}
+		timer_wheel_->schedule(&heartbeat_send_timer_, due);
+	}
+
+	void LibwebsocketsClient::onHeartbeatReceiveTimer()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::milliseconds timeout(heartbeat_receive_interval_ + heartbeat_receive_interval_ * get_heartbeat_grace_percent() / 100);
+		std::chrono::steady_clock::time_point deadline = heartbeat_received_ticks_ + timeout;
+
+		if (heartbeat_receive_interval_ <= 0)
+			return;
+
+		if (now < deadline) {
+			timer_wheel_->schedule(&heartbeat_receive_timer_, deadline);
+			return;
+		}
+
+		// Half-open or dead peer
+		stopHeartbeat();
+		onHeartbeatTimeout();
+		if (wsi_)
+			lws_set_timeout(wsi_, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+	}
+
 	int LibwebsocketsClient::onFrameConnected(Frame* frame)
 	{
 		if(frame->has_header(Frame::Headers::HEART_BEAT)) {
@@ -185,22 +734,108 @@ namespace stomp {
 				}
 			}
 		}
-		heartbeat_send_interval_ = (heartbeat_cx_ > heartbeat_sy_) ? heartbeat_cx_ : heartbeat_sy_;
+		// STOMP 1.1: no heart-beats in a direction where either side offers 0
+		heartbeat_send_interval_ = ((heartbeat_cx_ > 0) && (heartbeat_sy_ > 0)) ? ((heartbeat_cx_ > heartbeat_sy_) ? heartbeat_cx_ : heartbeat_sy_) : 0;
+		heartbeat_receive_interval_ = ((heartbeat_cy_ > 0) && (heartbeat_sx_ > 0)) ? ((heartbeat_cy_ > heartbeat_sx_) ? heartbeat_cy_ : heartbeat_sx_) : 0;
 
-		heartbeat_prev_ticks_ = std::chrono::steady_clock::now();
 		state_ = State::CONNECTED;
+		startHeartbeat();
 
 		return onConnected(frame);
 	}
 
-	int LibwebsocketsClient::sendFrame(Frame* frame)
+	int LibwebsocketsClient::sendFrameBuffer(Frame* frame, bool bounded)
 	{
-		std::unique_ptr<MessageVectorBuffer> buffer(new MessageVectorBuffer());
+		std::unique_ptr<MessageVectorBuffer> buffer;
+		std::unique_ptr<LwsMessageBuffer> temp;
+		int rc;
+		// Cheap refusal before serializing
+		if (bounded && sendQueueOver(send_queue_bytes_.load() + 1, send_queue_count_.load() + 1, 0)) {
+			send_queue_refused_.store(true);
+			return SEND_QUEUE_FULL;
+		}
+		buffer = acquireSendBuffer();
 		frame->make_payload_append(buffer->writePrepare());
 		buffer->writeDone();
-		send_queue_lock_.lock();
-		send_queue_data_.push_back(std::move(buffer));
-		send_queue_lock_.unlock();
+		temp = std::move(buffer);
+		rc = queueSendData(temp, bounded);
+		if (rc == SEND_OK)
+			wakeService();
+		return rc;
+	}
+
+	int LibwebsocketsClient::sendFrame(Frame* frame)
+	{
+		return sendFrameBuffer(frame, false);
+	}
+
+	int LibwebsocketsClient::sendFrames(Frame* const* frames, size_t count)
+	{
+		std::unique_ptr<MessageVectorBuffer> buffer;
+		std::unique_ptr<LwsMessageBuffer> temp;
+		int rc;
+		if (!count)
+			return SEND_OK;
+		buffer = acquireSendBuffer();
+		{
+			std::vector<char>& output = buffer->writePrepare();
+			for (size_t i = 0; i < count; i++)
+				frames[i]->make_payload_append(output);
+		}
+		buffer->writeDone();
+		temp = std::move(buffer);
+		rc = queueSendData(temp);
+		if (rc == SEND_OK)
+			wakeService();
+		return rc;
+	}
+
+	int LibwebsocketsClient::trySendFrame(Frame* frame)
+	{
+		return sendFrameBuffer(frame, true);
+	}
+
+	int LibwebsocketsClient::sendFrame(Frame* frame, int timeout_ms)
+	{
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+		unsigned close_count = close_count_.load();
+		int rc;
+		for (;;) {
+			rc = sendFrameBuffer(frame, true);
+			if (rc != SEND_QUEUE_FULL)
+				return rc;
+			{
+				std::unique_lock<std::mutex> lock(send_space_lock_);
+				bool full;
+				send_space_waiters_.fetch_add(1);
+				// Checked after registering, so a drain or close in between still notifies
+				full = (close_count_.load() == close_count) && sendQueueOver(send_queue_bytes_.load() + 1, send_queue_count_.load() + 1, 0);
+				if (full) {
+					if (timeout_ms < 0)
+						send_space_cond_.wait(lock);
+					else
+						send_space_cond_.wait_until(lock, deadline);
+				}
+				send_space_waiters_.fetch_sub(1);
+			}
+			if (close_count_.load() != close_count)
+				return SEND_ERROR;
+			if ((timeout_ms >= 0) && (std::chrono::steady_clock::now() >= deadline)) {
+				rc = sendFrameBuffer(frame, true);
+				return (rc == SEND_QUEUE_FULL) ? SEND_TIMEOUT : rc;
+			}
+		}
+	}
+
+	int LibwebsocketsClient::sendFrame(std::unique_ptr<Frame> frame)
+	{
+		std::unique_ptr<LwsMessageBuffer> buffer;
+		// In-place fragments need the post-padding to be empty
+		if ((frame->body().size() <= (size_t)get_send_fragment_size()) || (get_send_buffer_post_padding() > 0))
+			return sendFrame(frame.get());
+		buffer.reset(new MessageFrameBuffer(std::move(frame)));
+		queueSendData(buffer);
+		wakeService();
 		return 0;
 	}
 
@@ -209,6 +844,20 @@ namespace stomp {
 		return sendFrame(item->frame());
 	}
 
+	int LibwebsocketsClient::sendPrepared(const command::PreparedSend* prepared, const char* body, size_t body_length)
+	{
+		std::unique_ptr<MessageVectorBuffer> buffer(acquireSendBuffer());
+		std::unique_ptr<LwsMessageBuffer> temp;
+		int rc;
+		prepared->make_payload_append(body, body_length, buffer->writePrepare());
+		buffer->writeDone();
+		temp = std::move(buffer);
+		rc = queueSendData(temp, true);
+		if (rc == SEND_OK)
+			wakeService();
+		return rc;
+	}
+
 	std::string LibwebsocketsClient::generateSubscribeId()
 	{
 		std::unique_lock<std::mutex> lock{ id_lock_ };
@@ -240,6 +889,22 @@ namespace stomp {
 	int LibwebsocketsClient::get_timer_period_us() {
 		return 100000;
 	}
+
+	int LibwebsocketsClient::get_send_fragment_size() {
+		return 65536;
+	}
+
+	int LibwebsocketsClient::get_heartbeat_grace_percent() {
+		return 50;
+	}
+
+	int LibwebsocketsClient::get_send_buffer_pool_size() {
+		return 64;
+	}
+
+	int LibwebsocketsClient::get_send_buffer_pool_max_capacity() {
+		return 262144;
+	}
 }
 
 #endif /* HAS_LIBWEBSOCKETS */
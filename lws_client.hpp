@@ -14,12 +14,18 @@
 #include <libwebsockets.h>
 
 #include <vector>
-#include <deque>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 
 #include "frame_reader.hpp"
+#include "frame_pool.hpp"
+#include "message_dispatcher.hpp"
+#include "memory_resource.hpp"
+#include "mpsc_queue.hpp"
+#include "timer_wheel.hpp"
 
 #ifdef _DEBUG
 #include <assert.h>
@@ -32,8 +38,35 @@ namespace stomp {
 		static int get_send_buffer_pre_padding();
 		static int get_send_buffer_post_padding();
 		static int get_timer_period_us();
+		static int get_send_fragment_size();
+		static int get_send_buffer_pool_size();
+		static int get_send_buffer_pool_max_capacity();
+		static int get_heartbeat_grace_percent();
 
-		class MessageVectorBuffer : public MessageBuffer {
+		class LwsMessageBuffer : public MessageBuffer, public MpscNode {
+		public:
+			/**
+			 * Writes the message, or its next fragment.
+			 * @return negative on error, 0 if the message is complete, 1 if fragments remain
+			 */
+			virtual int write(struct lws* wsi);
+
+			/**
+			 * @return true if this is a MessageVectorBuffer that can go back to the pool.
+			 */
+			virtual bool recyclable() const {
+				return false;
+			}
+
+			/**
+			 * @return Bytes this buffer holds while queued, counted against the send queue limits.
+			 */
+			virtual size_t queued_size() {
+				return data_size();
+			}
+		};
+
+		class MessageVectorBuffer : public LwsMessageBuffer {
 		private:
 			int data_size_;
 			std::vector<char> buffer_;
@@ -56,6 +89,14 @@ namespace stomp {
 				data_size_ = data_size;
 			}
 
+			bool recyclable() const override {
+				return true;
+			}
+
+			size_t capacity() const {
+				return buffer_.capacity();
+			}
+
 			std::vector<char>& writePrepare() {
 				data_size_ = 0;
 				buffer_.clear();
@@ -71,16 +112,120 @@ namespace stomp {
 			}
 		};
 
+		/**
+		 * Sends a frame as several WebSocket fragments without copying its body.
+		 * The head fragment carries the header block and the first pre-padding bytes
+		 * of the body, so every following body fragment can be written in place.
+		 */
+		class MessageFrameBuffer : public LwsMessageBuffer {
+		private:
+			std::unique_ptr<Frame> frame_;
+			MessageVectorBuffer head_;
+			MessageVectorBuffer trailer_;
+			size_t body_offset_;
+			size_t queued_size_;
+			bool head_sent_;
+
+		public:
+			MessageFrameBuffer(std::unique_ptr<Frame> frame);
+
+			char* data_ptr() override {
+				return head_.data_ptr();
+			}
+			int data_size() override {
+				return head_.data_size();
+			}
+			size_t queued_size() override {
+				return queued_size_;
+			}
+
+			int write(struct lws* wsi) override;
+		};
+
 	private:
+		class ReceiveHandler : public FrameHandler, public MessageDispatcher::Target {
+		private:
+			LibwebsocketsClient* client_;
+
+		public:
+			ReceiveHandler(LibwebsocketsClient* client)
+				: client_(client) {}
+
+			int onFrame(Frame* frame) override;
+			int onFrameView(const FrameView& view) override;
+			int onFrameHeaders(Frame* frame) override;
+			int onFrameChunk(Frame* frame, const char* data, int len, bool is_last) override;
+
+			void onDispatch(Frame* frame) override;
+		};
+
+		class HeartbeatTimer : public TimerWheel::Timer {
+		private:
+			LibwebsocketsClient* client_;
+			bool receive_;
+
+		public:
+			HeartbeatTimer(LibwebsocketsClient* client, bool receive)
+				: client_(client), receive_(receive) {}
+
+			void onTimer() override;
+		};
+
 		bool use_lws_timer_;
 
 		struct lws* wsi_;
+		// Context of wsi_, for lws_cancel_service from application threads
+		std::atomic<struct lws_context*> context_;
+		// A wakeup is on its way to the service thread
+		std::atomic<bool> wake_pending_;
 		State state_;
 
+		MemoryResource* memory_resource_;
+		FramePool frame_pool_;
 		FrameReader frame_reader_;
+		ReceiveHandler receive_handler_;
 
-		std::mutex send_queue_lock_;
-		std::deque<std::unique_ptr<MessageBuffer> > send_queue_data_;
+		// MESSAGE frames go to worker threads when set
+		MessageDispatcher* dispatcher_;
+		// Ordering key header, empty for the subscription id
+		std::string dispatch_key_header_;
+		// Posted frames not yet delivered
+		std::atomic<size_t> dispatch_pending_;
+		std::mutex dispatch_lock_;
+		std::condition_variable dispatch_cond_;
+
+		std::mutex send_pool_lock_;
+		std::vector<MessageVectorBuffer*> send_pool_;
+
+		// Any thread pushes, the service thread pops
+		MpscQueue<LwsMessageBuffer> send_queue_;
+		// Queued items, their queued_size() total and the steady_clock ticks when the queue became non-empty
+		std::atomic<size_t> send_queue_count_;
+		std::atomic<size_t> send_queue_bytes_;
+		std::atomic<int64_t> send_queue_since_;
+		// Popped but not yet taken (coalescing look-ahead), only touched by the service thread
+		std::unique_ptr<LwsMessageBuffer> send_queue_front_;
+		// Partially written message, only touched by the service thread
+		std::unique_ptr<LwsMessageBuffer> writing_buffer_;
+
+		// Limits for bounded sends, 0 for none
+		size_t send_queue_max_bytes_;
+		size_t send_queue_max_frames_;
+		size_t send_queue_low_bytes_;
+		size_t send_queue_low_frames_;
+		// Set when a bounded send was refused, cleared with onSendQueueLow()
+		std::atomic<bool> send_queue_refused_;
+		// Senders blocked in sendFrame(frame, timeout_ms)
+		std::atomic<int> send_space_waiters_;
+		std::mutex send_space_lock_;
+		std::condition_variable send_space_cond_;
+		// Bumped by onSocketClosed; a change fails the blocked senders
+		std::atomic<unsigned> close_count_;
+
+		int write_coalesce_bytes_;
+		int write_linger_us_;
+		// Buffers being merged into one write, only touched by the service thread
+		std::vector<std::unique_ptr<LwsMessageBuffer> > coalesce_items_;
 
 		std::mutex id_lock_;
 		int64_t id_tx_count_;
@@ -91,13 +236,34 @@ namespace stomp {
 		int heartbeat_sx_;
 		int heartbeat_sy_;
 		int heartbeat_send_interval_;
+		int heartbeat_receive_interval_;
+		// Last write / last received bytes, service thread only
 		std::chrono::steady_clock::time_point heartbeat_prev_ticks_;
+		std::chrono::steady_clock::time_point heartbeat_received_ticks_;
+
+		// Shared wheel from setTimerWheel, or own_timer_wheel_ advanced by timerProc
+		TimerWheel* timer_wheel_;
+		std::unique_ptr<TimerWheel> own_timer_wheel_;
+		HeartbeatTimer heartbeat_send_timer_;
+		HeartbeatTimer heartbeat_receive_timer_;
 
 #ifdef _DEBUG
 		LibwebsocketsClient(const LibwebsocketsClient& o) { assert(false); }
 #endif
 
-		void pushSendData(std::unique_ptr<MessageBuffer> & item);
+		void pushSendData(std::unique_ptr<LwsMessageBuffer> & item);
+		int queueSendData(std::unique_ptr<LwsMessageBuffer> & item, bool bounded = false);
+		LwsMessageBuffer* peekSendData();
+		void takeSendData(std::unique_ptr<LwsMessageBuffer> & out);
+		bool sendQueueOver(size_t bytes, size_t frames, size_t incoming) const;
+		void wakeService();
+		void onSendQueueTaken();
+		void dropSendData();
+		int sendFrameBuffer(Frame* frame, bool bounded);
+		int lingerRemainingUs() const;
+		void coalesceSendData(size_t total_size);
+		std::unique_ptr<MessageVectorBuffer> acquireSendBuffer();
+		void recycleSendBuffer(std::unique_ptr<LwsMessageBuffer>& item);
 		void sendConnectFrame();
 
 		int onSocketWriteable(struct lws* wsi);
@@ -105,19 +271,107 @@ namespace stomp {
 		int onSocketClosed();
 
 		int onFrameConnected(Frame* frame);
+		int onFrameError(Frame* frame);
+		void postMessage(Frame* frame);
+		void waitDispatched();
+		void startHeartbeat();
+		void stopHeartbeat();
+		void onHeartbeatSendTimer();
+		void onHeartbeatReceiveTimer();
+
+	protected:
+		/**
+		 * Service thread: called for every MESSAGE before it is delivered, with its
+		 * ack header (empty if it has none).
+		 */
+		virtual void onMessageAck(const StringRef& ack) {}
 
 	public:
-		LibwebsocketsClient(bool use_lws_timer = true);
+		/**
+		 * @param resource Memory for pooled Frame objects, NULL for operator new / delete.
+		 *                 It must outlive the client.
+		 */
+		LibwebsocketsClient(bool use_lws_timer = true, MemoryResource* resource = NULL);
 		virtual ~LibwebsocketsClient();
 
+		/**
+		 * Forward every protocol callback here, including LWS_CALLBACK_EVENT_WAIT_CANCELLED
+		 * (it has no connection wsi): sends from other threads wake the service loop with it.
+		 */
 		int callbackProtocol(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len, bool *processed);
 
+		/**
+		 * Advances the client's own timer wheel (heart-beats) and flushes pending
+		 * data. Runs from the lws timer unless use_lws_timer is false.
+		 */
 		void timerProc();
 
+		/**
+		 * Schedules heart-beats on a wheel shared by the connections of one service
+		 * thread instead of a per-connection one; the owner calls TimerWheel::advance
+		 * on that thread about once per tick. Set before connecting, NULL to go back.
+		 * The per-connection lws timer is then only used for write linger.
+		 */
+		void setTimerWheel(TimerWheel* wheel);
+
+		/**
+		 * Delivers MESSAGE frames (and bound subscription handlers) on the worker
+		 * threads of dispatcher instead of the service thread. Frames with the same
+		 * key_header value (by default: the same subscription) keep their order.
+		 * Streamed messages (setStreamingThreshold) stay on the service thread.
+		 *
+		 * Set before connecting. Setting NULL waits for the frames in flight; do so
+		 * before destroying a subclass whose onMessage the workers may be running.
+		 */
+		void setMessageDispatcher(MessageDispatcher* dispatcher, const std::string& key_header = std::string());
+
+		/**
+		 * MESSAGE frames with a content-length above threshold bytes are delivered
+		 * through onMessageStart / onMessageChunk. 0 (default) disables streaming.
+		 */
+		void setStreamingThreshold(int threshold);
+
+		/**
+		 * Largest received frame that is buffered, see FrameReader::set_max_frame_size;
+		 * a bigger one closes the connection.
+		 */
+		void setMaxFrameSize(size_t bytes);
+
+		/**
+		 * Merges queued frames into one WebSocket message of up to max_bytes
+		 * (STOMP allows several frames per message). 0 (default) writes one frame
+		 * per writable callback.
+		 * With linger_us > 0 a write below max_bytes waits up to linger_us for more
+		 * frames; without the lws timer, timerProc must run at least that often.
+		 */
+		void setWriteCoalescing(int max_bytes, int linger_us = 0);
+
+		/**
+		 * Limits for trySendFrame, sendFrame(frame, timeout_ms) and sendPrepared.
+		 * Other sends (commands, heartbeats) are always queued but still count.
+		 * A frame larger than max_bytes is accepted into an empty queue.
+		 * 0 disables a limit; low-water marks of 0 default to half the limit.
+		 */
+		void setSendQueueLimits(size_t max_bytes, size_t max_frames = 0, size_t low_water_bytes = 0, size_t low_water_frames = 0);
+		size_t sendQueueBytes() const;
+		size_t sendQueueFrames() const;
+
 		State state() const override;
 
 		int sendFrame(Frame* frame) override;
+		int sendFrame(std::unique_ptr<Frame> frame) override;
+		int trySendFrame(Frame* frame) override;
+		/**
+		 * Must not be called from the lws service thread, which is the one draining the queue.
+		 * Fails with SEND_ERROR if the connection closes while waiting.
+		 */
+		int sendFrame(Frame* frame, int timeout_ms) override;
+		/**
+		 * Encodes the frames into one WebSocket message.
+		 */
+		int sendFrames(Frame* const* frames, size_t count) override;
 		int sendCommand(command::Base* item) override;
+		int sendPrepared(const command::PreparedSend* prepared, const char* body, size_t body_length) override;
 
 		std::string generateSubscribeId() override;
 		std::string generateTransactionId() override;
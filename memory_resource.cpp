@@ -0,0 +1,99 @@
+/**
+ * @file	memory_resource.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "memory_resource.hpp"
+
+#include <new>
+
+#include <stdint.h>
+
+namespace stomp {
+
+	namespace {
+		class NewDeleteResource : public MemoryResource {
+		public:
+			void* allocate(size_t bytes, size_t alignment) override {
+				if (!alignment || (alignment & (alignment - 1)))
+					throw std::bad_alloc();
+				return ::operator new(bytes);
+			}
+			void deallocate(void* p, size_t bytes, size_t alignment) override {
+				::operator delete(p);
+			}
+		};
+	}
+
+	MemoryResource* MemoryResource::new_delete()
+	{
+		static NewDeleteResource instance;
+		return &instance;
+	}
+
+	MonotonicBufferResource::MonotonicBufferResource(size_t initial_size, MemoryResource* upstream)
+		: upstream_(upstream ? upstream : MemoryResource::new_delete()),
+		blocks_(NULL),
+		current_(NULL),
+		remaining_(0),
+		next_block_size_(initial_size ? initial_size : 4096)
+	{
+	}
+
+	MonotonicBufferResource::~MonotonicBufferResource()
+	{
+		release();
+	}
+
+	void* MonotonicBufferResource::allocate(size_t bytes, size_t alignment)
+	{
+		if (!alignment || (alignment & (alignment - 1)))
+			throw std::bad_alloc();
+
+		uintptr_t address = (uintptr_t)current_;
+		size_t padding = (alignment - (address % alignment)) % alignment;
+
+		if (!current_ || (padding + bytes > remaining_)) {
+			size_t block_size = next_block_size_;
+			Block* block;
+			while (block_size < bytes + alignment + sizeof(Block))
+				block_size *= 2;
+			block = (Block*)upstream_->allocate(block_size, alignof(Block));
+			block->next = blocks_;
+			block->size = block_size;
+			blocks_ = block;
+			current_ = (char*)block + sizeof(Block);
+			remaining_ = block_size - sizeof(Block);
+			next_block_size_ = block_size * 2;
+
+			address = (uintptr_t)current_;
+			padding = (alignment - (address % alignment)) % alignment;
+		}
+
+		current_ += padding;
+		remaining_ -= padding;
+		void* result = current_;
+		current_ += bytes;
+		remaining_ -= bytes;
+		return result;
+	}
+
+	void MonotonicBufferResource::deallocate(void* p, size_t bytes, size_t alignment)
+	{
+	}
+
+	void MonotonicBufferResource::release()
+	{
+		while (blocks_) {
+			Block* next = blocks_->next;
+			upstream_->deallocate(blocks_, blocks_->size, alignof(Block));
+			blocks_ = next;
+		}
+		current_ = NULL;
+		remaining_ = 0;
+	}
+
+}
@@ -0,0 +1,76 @@
+/**
+ * @file	memory_resource.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+
+namespace stomp {
+
+	/**
+	 * Polymorphic allocation hook, modeled on std::pmr::memory_resource (C++17)
+	 * so that it can be used from C++11.
+	 *
+	 * FramePool places its Frame objects in a resource; the strings and vectors
+	 * inside a frame still use std::allocator and keep their capacity across
+	 * reuse instead. alignment must be a power of two, allocate() throws
+	 * std::bad_alloc otherwise.
+	 */
+	class MemoryResource {
+	public:
+		virtual ~MemoryResource() {}
+
+		virtual void* allocate(size_t bytes, size_t alignment) = 0;
+		virtual void deallocate(void* p, size_t bytes, size_t alignment) = 0;
+
+		/**
+		 * @return Process wide resource using operator new / delete.
+		 */
+		static MemoryResource* new_delete();
+	};
+
+	/**
+	 * Arena that hands out memory from growing blocks and frees everything at
+	 * once in release(). deallocate() is a no-op. Not thread safe.
+	 *
+	 * As the resource of a FramePool, the arena holds the Frame objects the
+	 * pool creates and keeps cached: it must outlive the pool, and release()
+	 * may only be called once the pool and every frame taken from it are gone.
+	 * Frames a full pool lets go of are not reclaimed until then, so size the
+	 * pool for the peak number of frames in use.
+	 */
+	class MonotonicBufferResource : public MemoryResource {
+	private:
+		struct Block {
+			Block* next;
+			size_t size;
+		};
+
+		MemoryResource* upstream_;
+		Block* blocks_;
+		char* current_;
+		size_t remaining_;
+		size_t next_block_size_;
+
+		MonotonicBufferResource(const MonotonicBufferResource& o);
+		MonotonicBufferResource& operator=(const MonotonicBufferResource& o);
+
+	public:
+		MonotonicBufferResource(size_t initial_size = 4096, MemoryResource* upstream = NULL);
+		virtual ~MonotonicBufferResource();
+
+		void* allocate(size_t bytes, size_t alignment) override;
+		void deallocate(void* p, size_t bytes, size_t alignment) override;
+
+		/**
+		 * Frees all blocks. Memory handed out before becomes invalid.
+		 */
+		void release();
+	};
+
+}
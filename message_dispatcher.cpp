@@ -0,0 +1,185 @@
+/**
+ * @file	message_dispatcher.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "message_dispatcher.hpp"
+
+namespace stomp {
+
+	MessageDispatcher::Target::~Target()
+	{
+		Item* item;
+		while ((item = free_items_.pop()) != NULL)
+			delete item;
+	}
+
+	MessageDispatcher::MessageDispatcher(int worker_count, size_t strand_count)
+		: batch_size_(64),
+		ready_count_(0),
+		pending_(0),
+		idle_workers_(0),
+		stopping_(false)
+	{
+		size_t i;
+		if (worker_count <= 0)
+			worker_count = (int)std::thread::hardware_concurrency();
+		if (worker_count <= 0)
+			worker_count = 1;
+		if (!strand_count)
+			strand_count = 1;
+
+		for (i = 0; i < (size_t)worker_count; i++)
+			workers_.emplace_back(new Worker());
+		for (i = 0; i < strand_count; i++) {
+			strands_.emplace_back(new Strand());
+			strands_.back()->home_ = i % workers_.size();
+		}
+		for (i = 0; i < workers_.size(); i++)
+			workers_[i]->thread_ = std::thread(&MessageDispatcher::worker_main, this, i);
+	}
+
+	MessageDispatcher::~MessageDispatcher()
+	{
+		size_t i;
+		wait_idle();
+		{
+			std::unique_lock<std::mutex> lock(idle_lock_);
+			stopping_.store(true);
+			idle_cond_.notify_all();
+		}
+		for (i = 0; i < workers_.size(); i++)
+			workers_[i]->thread_.join();
+	}
+
+	void MessageDispatcher::set_batch_size(size_t batch_size)
+	{
+		batch_size_ = batch_size ? batch_size : 1;
+	}
+
+	size_t MessageDispatcher::worker_count() const
+	{
+		return workers_.size();
+	}
+
+	size_t MessageDispatcher::pending() const
+	{
+		return pending_.load();
+	}
+
+	void MessageDispatcher::post(const StringRef& key, Target* target, Frame* frame)
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ULL;
+		Strand* strand;
+		Item* item = target->free_items_.pop();
+		if (!item)
+			item = new Item();
+		for (size_t i = 0; i < key.size(); i++)
+			hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+		strand = strands_[hash % strands_.size()].get();
+
+		item->target = target;
+		item->frame = frame;
+		pending_.fetch_add(1);
+		strand->queue_.push(item);
+		if (strand->count_.fetch_add(1) == 0)
+			schedule(strand, strand->home_);
+	}
+
+	void MessageDispatcher::schedule(Strand* strand, size_t worker)
+	{
+		{
+			std::unique_lock<std::mutex> lock(workers_[worker]->lock_);
+			workers_[worker]->ready_.push_back(strand);
+		}
+		ready_count_.fetch_add(1);
+		if (idle_workers_.load() > 0) {
+			std::unique_lock<std::mutex> lock(idle_lock_);
+			idle_cond_.notify_one();
+		}
+	}
+
+	MessageDispatcher::Strand* MessageDispatcher::take(size_t worker)
+	{
+		size_t i;
+		Strand* strand = NULL;
+
+		{
+			std::unique_lock<std::mutex> lock(workers_[worker]->lock_);
+			if (!workers_[worker]->ready_.empty()) {
+				strand = workers_[worker]->ready_.front();
+				workers_[worker]->ready_.pop_front();
+			}
+		}
+		// Steal from the back of the other deques
+		for (i = 1; !strand && (i < workers_.size()); i++) {
+			Worker* victim = workers_[(worker + i) % workers_.size()].get();
+			std::unique_lock<std::mutex> lock(victim->lock_);
+			if (!victim->ready_.empty()) {
+				strand = victim->ready_.back();
+				victim->ready_.pop_back();
+			}
+		}
+		if (strand)
+			ready_count_.fetch_sub(1);
+		return strand;
+	}
+
+	void MessageDispatcher::run_strand(Strand* strand, size_t worker)
+	{
+		size_t count;
+		for (count = 0; count < batch_size_; count++) {
+			Item* item = strand->queue_.pop();
+			Target* target;
+			Frame* frame;
+			if (!item) {
+				// count_ says there is one: its producer is still linking it
+				break;
+			}
+			target = item->target;
+			frame = item->frame;
+			// Returned first: the target may be destroyed once onDispatch lets go
+			target->free_items_.push(item);
+			target->onDispatch(frame);
+			if (pending_.fetch_sub(1) == 1) {
+				std::unique_lock<std::mutex> lock(idle_lock_);
+				drained_cond_.notify_all();
+			}
+			if (strand->count_.fetch_sub(1) == 1)
+				return;
+		}
+		// Items remain: requeue behind the other ready strands
+		schedule(strand, worker);
+	}
+
+	void MessageDispatcher::worker_main(size_t worker)
+	{
+		for (;;) {
+			Strand* strand = take(worker);
+			if (strand) {
+				run_strand(strand, worker);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(idle_lock_);
+			idle_workers_.fetch_add(1);
+			while (!ready_count_.load() && !stopping_.load())
+				idle_cond_.wait(lock);
+			idle_workers_.fetch_sub(1);
+			if (stopping_.load() && !ready_count_.load())
+				return;
+		}
+	}
+
+	void MessageDispatcher::wait_idle()
+	{
+		std::unique_lock<std::mutex> lock(idle_lock_);
+		while (pending_.load())
+			drained_cond_.wait(lock);
+	}
+
+}
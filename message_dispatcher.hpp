@@ -0,0 +1,138 @@
+/**
+ * @file	message_dispatcher.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "string_ref.hpp"
+#include "frame.hpp"
+#include "mpsc_queue.hpp"
+
+namespace stomp {
+
+	/**
+	 * Runs MESSAGE handlers on a pool of worker threads.
+	 *
+	 * Frames are ordered by key (the subscription id, or a header chosen by the
+	 * client): every key hashes to a strand, a strand is run by one worker at a
+	 * time, and runs its frames in posting order. Strands become ready on the
+	 * deque of their home worker; idle workers steal ready strands from the
+	 * others, so one busy key does not hold up the rest.
+	 *
+	 * Keys sharing a strand are serialized together; use enough strands for the
+	 * number of concurrent keys.
+	 */
+	class MessageDispatcher {
+	public:
+		class Target;
+
+	private:
+		struct Item : public MpscNode {
+			Target* target;
+			Frame* frame;
+		};
+
+	public:
+		class Target {
+		private:
+			friend class MessageDispatcher;
+
+			// Dispatched items, reused by the next post() for this target
+			MpscQueue<Item> free_items_;
+
+		public:
+			virtual ~Target();
+			/**
+			 * Called on a worker thread. The target owns frame from here on.
+			 */
+			virtual void onDispatch(Frame* frame) = 0;
+		};
+
+	private:
+
+		struct Strand {
+			MpscQueue<Item> queue_;
+			// Queued items; the post that raises it from 0 schedules the strand,
+			// the worker that brings it back to 0 releases it
+			std::atomic<size_t> count_;
+			size_t home_;
+
+			Strand() : count_(0), home_(0) {}
+		};
+
+		struct Worker {
+			std::mutex lock_;
+			std::deque<Strand*> ready_;
+			std::thread thread_;
+		};
+
+		std::vector<std::unique_ptr<Strand> > strands_;
+		std::vector<std::unique_ptr<Worker> > workers_;
+		size_t batch_size_;
+
+		// Strands on ready deques
+		std::atomic<size_t> ready_count_;
+		// Posted, not yet dispatched frames
+		std::atomic<size_t> pending_;
+		std::atomic<int> idle_workers_;
+		std::atomic<bool> stopping_;
+		std::mutex idle_lock_;
+		std::condition_variable idle_cond_;
+		std::condition_variable drained_cond_;
+
+		MessageDispatcher(const MessageDispatcher& o);
+		MessageDispatcher& operator=(const MessageDispatcher& o);
+
+		void schedule(Strand* strand, size_t worker);
+		Strand* take(size_t worker);
+		void run_strand(Strand* strand, size_t worker);
+		void worker_main(size_t worker);
+
+	public:
+		/**
+		 * @param worker_count 0: std::thread::hardware_concurrency()
+		 * @param strand_count Ordering slots keys are hashed into
+		 */
+		MessageDispatcher(int worker_count = 0, size_t strand_count = 1024);
+		/**
+		 * Waits for the posted frames, then stops the workers.
+		 */
+		~MessageDispatcher();
+
+		/**
+		 * Frames per strand run before the worker lets other strands go first.
+		 */
+		void set_batch_size(size_t batch_size);
+
+		size_t worker_count() const;
+		size_t pending() const;
+
+		/**
+		 * Queues frame for target->onDispatch after every earlier frame posted with
+		 * a key of the same strand. Does not allocate once the target has items
+		 * to reuse; frames for one target must be posted from one thread at a time.
+		 */
+		void post(const StringRef& key, Target* target, Frame* frame);
+
+		/**
+		 * Blocks until every posted frame has been dispatched.
+		 */
+		void wait_idle();
+	};
+
+}
@@ -0,0 +1,98 @@
+/**
+ * @file	mpsc_queue.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+
+namespace stomp {
+
+	/**
+	 * Link embedded in every object that goes through an MpscQueue.
+	 */
+	class MpscNode {
+	public:
+		std::atomic<MpscNode*> mpsc_next_;
+
+		MpscNode() : mpsc_next_(NULL) {}
+	};
+
+	/**
+	 * Intrusive lock-free multi-producer / single-consumer FIFO (Vyukov).
+	 * push() is wait-free and may be called from any thread; pop() must only be
+	 * called from the one consumer thread. The queue does not own the nodes.
+	 *
+	 * T must derive from MpscNode.
+	 */
+	template<typename T>
+	class MpscQueue {
+	private:
+		std::atomic<MpscNode*> head_;
+		MpscNode* tail_;
+		MpscNode stub_;
+
+		MpscQueue(const MpscQueue& o);
+		MpscQueue& operator=(const MpscQueue& o);
+
+		void push_node(MpscNode* node) {
+			MpscNode* prev;
+			node->mpsc_next_.store(NULL, std::memory_order_relaxed);
+			prev = head_.exchange(node, std::memory_order_acq_rel);
+			prev->mpsc_next_.store(node, std::memory_order_release);
+		}
+
+	public:
+		MpscQueue()
+			: head_(&stub_), tail_(&stub_) {}
+
+		void push(T* item) {
+			push_node(item);
+		}
+
+		/**
+		 * @return The oldest item, or NULL if the queue is empty or a producer is
+		 *         still linking its item (it will be visible on a later call).
+		 */
+		T* pop() {
+			MpscNode* tail = tail_;
+			MpscNode* next = tail->mpsc_next_.load(std::memory_order_acquire);
+			MpscNode* head;
+			if (tail == &stub_) {
+				if (!next)
+					return NULL;
+				tail_ = next;
+				tail = next;
+				next = next->mpsc_next_.load(std::memory_order_acquire);
+			}
+			if (next) {
+				tail_ = next;
+				return static_cast<T*>(tail);
+			}
+			head = head_.load(std::memory_order_acquire);
+			if (tail != head)
+				return NULL;
+			push_node(&stub_);
+			next = tail->mpsc_next_.load(std::memory_order_acquire);
+			if (next) {
+				tail_ = next;
+				return static_cast<T*>(tail);
+			}
+			return NULL;
+		}
+
+		/**
+		 * Consumer side only.
+		 */
+		bool empty() const {
+			return (tail_ == &stub_) && !stub_.mpsc_next_.load(std::memory_order_acquire);
+		}
+	};
+
+}
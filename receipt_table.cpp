@@ -0,0 +1,166 @@
+/**
+ * @file	receipt_table.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "receipt_table.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace stomp {
+
+	static const char receipt_prefix[] = "rcpt-";
+
+	static bool compare_sequence(const std::pair<uint64_t, ReceiptTable::Callback>& a, const std::pair<uint64_t, ReceiptTable::Callback>& b)
+	{
+		return a.first < b.first;
+	}
+
+	ReceiptTable::ReceiptTable()
+		: next_sequence_(0), window_(0), in_flight_(0)
+	{
+	}
+
+	std::string ReceiptTable::format_id(uint64_t sequence)
+	{
+		char buf[64];
+		snprintf(buf, sizeof(buf), "%s%llx", receipt_prefix, (unsigned long long)sequence);
+		return buf;
+	}
+
+	bool ReceiptTable::parse_id(const StringRef& id, uint64_t& sequence)
+	{
+		size_t prefix_length = sizeof(receipt_prefix) - 1;
+		size_t i;
+		if ((id.size() <= prefix_length) || (id.size() > prefix_length + 16) || memcmp(id.data(), receipt_prefix, prefix_length))
+			return false;
+		sequence = 0;
+		for (i = prefix_length; i < id.size(); i++) {
+			char c = id[i];
+			int digit;
+			if ((c >= '0') && (c <= '9'))
+				digit = c - '0';
+			else if ((c >= 'a') && (c <= 'f'))
+				digit = c - 'a' + 10;
+			else
+				return false;
+			sequence = (sequence << 4) | (uint64_t)digit;
+		}
+		return true;
+	}
+
+	void ReceiptTable::set_window(size_t window)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		window_ = window;
+		window_cond_.notify_all();
+	}
+
+	size_t ReceiptTable::window() const
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return window_;
+	}
+
+	size_t ReceiptTable::in_flight() const
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return in_flight_;
+	}
+
+	bool ReceiptTable::acquire(int timeout_ms)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		if (timeout_ms < 0) {
+			while (window_ && (in_flight_ >= window_))
+				window_cond_.wait(lock);
+		}
+		else {
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+			while (window_ && (in_flight_ >= window_)) {
+				if (window_cond_.wait_until(lock, deadline) == std::cv_status::timeout) {
+					if (in_flight_ >= window_)
+						return false;
+				}
+			}
+		}
+		in_flight_++;
+		return true;
+	}
+
+	std::string ReceiptTable::add(const Callback& callback)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		uint64_t sequence = ++next_sequence_;
+		pending_[sequence] = callback;
+		return format_id(sequence);
+	}
+
+	void ReceiptTable::cancel(const std::string& receipt_id)
+	{
+		uint64_t sequence;
+		std::unique_lock<std::mutex> lock(lock_);
+		if (!parse_id(receipt_id, sequence) || !pending_.erase(sequence))
+			return;
+		in_flight_--;
+		window_cond_.notify_one();
+	}
+
+	bool ReceiptTable::complete(const StringRef& receipt_id, int status, const std::string& message)
+	{
+		Callback callback;
+		Result result;
+		uint64_t sequence;
+		if (!parse_id(receipt_id, sequence))
+			return false;
+		{
+			std::unique_lock<std::mutex> lock(lock_);
+			std::unordered_map<uint64_t, Callback>::iterator iter = pending_.find(sequence);
+			if (iter == pending_.end())
+				return false;
+			callback.swap(iter->second);
+			pending_.erase(iter);
+			in_flight_--;
+			window_cond_.notify_one();
+		}
+		result.status = status;
+		result.receipt_id = receipt_id.to_string();
+		result.message = message;
+		if (callback)
+			callback(result);
+		return true;
+	}
+
+	void ReceiptTable::fail_all(int status, const std::string& message)
+	{
+		std::vector<std::pair<uint64_t, Callback> > callbacks;
+		Result result;
+		{
+			std::unique_lock<std::mutex> lock(lock_);
+			callbacks.reserve(pending_.size());
+			for (std::unordered_map<uint64_t, Callback>::iterator iter = pending_.begin(); iter != pending_.end(); iter++)
+				callbacks.push_back(std::make_pair(iter->first, iter->second));
+			in_flight_ -= pending_.size();
+			pending_.clear();
+			window_cond_.notify_all();
+		}
+		// In request order
+		std::sort(callbacks.begin(), callbacks.end(), compare_sequence);
+		result.status = status;
+		result.message = message;
+		for (size_t i = 0; i < callbacks.size(); i++) {
+			result.receipt_id = format_id(callbacks[i].first);
+			if (callbacks[i].second)
+				callbacks[i].second(result);
+		}
+	}
+
+}
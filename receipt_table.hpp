@@ -0,0 +1,101 @@
+/**
+ * @file	receipt_table.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "string_ref.hpp"
+
+namespace stomp {
+
+	/**
+	 * Outstanding receipt requests, keyed by the generated receipt id.
+	 *
+	 * Ids are "rcpt-<hex sequence>", so a RECEIPT is matched by parsing the
+	 * number instead of hashing the string. An optional window bounds the
+	 * requests in flight; acquire() waits for a free slot.
+	 */
+	class ReceiptTable {
+	public:
+		enum Status {
+			RECEIPT_OK = 0,
+			// ERROR frame naming the receipt
+			RECEIPT_ERROR = -1,
+			// Connection closed before the receipt came
+			RECEIPT_CLOSED = -2,
+		};
+
+		struct Result {
+			int status;
+			std::string receipt_id;
+			// message header of the ERROR frame
+			std::string message;
+		};
+
+		typedef std::function<void(const Result&)> Callback;
+
+	private:
+		mutable std::mutex lock_;
+		std::condition_variable window_cond_;
+		std::unordered_map<uint64_t, Callback> pending_;
+		uint64_t next_sequence_;
+		size_t window_;
+		// Acquired slots
+		size_t in_flight_;
+
+		ReceiptTable(const ReceiptTable& o);
+		ReceiptTable& operator=(const ReceiptTable& o);
+
+		static std::string format_id(uint64_t sequence);
+		static bool parse_id(const StringRef& id, uint64_t& sequence);
+
+	public:
+		ReceiptTable();
+
+		/**
+		 * Receipts in flight at most, 0 (default) for no limit.
+		 */
+		void set_window(size_t window);
+		size_t window() const;
+		size_t in_flight() const;
+
+		/**
+		 * Takes a window slot, waiting up to timeout_ms (negative: no limit).
+		 * @return false on timeout
+		 */
+		bool acquire(int timeout_ms);
+		/**
+		 * Registers callback on an acquired slot.
+		 * @return Receipt id for the receipt header
+		 */
+		std::string add(const Callback& callback);
+		/**
+		 * Drops a request whose frame could not be sent, releasing its slot.
+		 */
+		void cancel(const std::string& receipt_id);
+
+		/**
+		 * Completes receipt_id; the callback runs on the calling thread.
+		 * @return false if receipt_id is unknown
+		 */
+		bool complete(const StringRef& receipt_id, int status, const std::string& message = std::string());
+		/**
+		 * Completes every request with status.
+		 */
+		void fail_all(int status, const std::string& message = std::string());
+	};
+
+}
@@ -0,0 +1,46 @@
+/**
+ * @file	scanner.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+namespace stomp {
+
+	/**
+	 * Delimiter search. find_byte is memchr; find_header_escape has SSE2 and
+	 * AVX2 kernels, SSE2 (or generic) is selected at runtime on first use.
+	 */
+	class Scanner {
+	public:
+		enum Isa {
+			ISA_GENERIC = 0,
+			ISA_SSE2 = 1,
+			ISA_AVX2 = 2,
+		};
+
+		/**
+		 * @return Pointer to the first c in [begin, end), or end if not found.
+		 */
+		static const char* find_byte(const char* begin, const char* end, char c);
+
+		/**
+		 * Finds the first byte that needs escaping in a header ('\r', '\n', ':' or '\\').
+		 * @return Pointer to the byte, or end if the span can be copied as is.
+		 */
+		static const char* find_header_escape(const char* begin, const char* end);
+
+		static Isa isa();
+		static const char* isa_name(Isa isa);
+		/**
+		 * Overrides the runtime selection (e.g. for benchmarks).
+		 * @return false if the CPU does not support isa.
+		 */
+		static bool select_isa(Isa isa);
+		static bool is_supported(Isa isa);
+	};
+
+}
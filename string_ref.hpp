@@ -0,0 +1,80 @@
+/**
+ * @file	string_ref.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <string>
+
+#include <string.h>
+
+namespace stomp {
+
+	/**
+	 * Non-owning (pointer, length) slice of characters.
+	 * The referenced memory must outlive the StringRef.
+	 */
+	class StringRef {
+	private:
+		const char* data_;
+		size_t size_;
+
+	public:
+		StringRef()
+			: data_(""), size_(0) {}
+		StringRef(const char* data, size_t size)
+			: data_(data), size_(size) {}
+		StringRef(const char* text)
+			: data_(text), size_(strlen(text)) {}
+		StringRef(const std::string& text)
+			: data_(text.data()), size_(text.size()) {}
+
+		const char* data() const {
+			return data_;
+		}
+		size_t size() const {
+			return size_;
+		}
+		bool empty() const {
+			return size_ == 0;
+		}
+		char operator[](size_t index) const {
+			return data_[index];
+		}
+
+		std::string to_string() const {
+			return std::string(data_, size_);
+		}
+
+		bool equals(const StringRef& other) const {
+			return (size_ == other.size_) && (memcmp(data_, other.data_, size_) == 0);
+		}
+
+		bool equals_ignore_case(const StringRef& other) const {
+			if (size_ != other.size_)
+				return false;
+			for (size_t i = 0; i < size_; i++) {
+				if (to_lower(data_[i]) != to_lower(other.data_[i]))
+					return false;
+			}
+			return true;
+		}
+
+		static char to_lower(char c) {
+			return ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+		}
+	};
+
+	inline bool operator==(const StringRef& a, const StringRef& b) {
+		return a.equals(b);
+	}
+
+	inline bool operator!=(const StringRef& a, const StringRef& b) {
+		return !a.equals(b);
+	}
+
+}
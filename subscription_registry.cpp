@@ -0,0 +1,206 @@
+/**
+ * @file	subscription_registry.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "subscription_registry.hpp"
+
+namespace stomp {
+
+	SubscriptionRegistry::SubscriptionRegistry()
+		: table_(std::make_shared<Table>()),
+		version_(0),
+		live_(std::make_shared<std::atomic<bool> >(true)),
+		count_(0)
+	{
+	}
+
+	SubscriptionRegistry::~SubscriptionRegistry()
+	{
+		// Threads drop their snapshot of this registry on their next lookup
+		live_->store(false, std::memory_order_relaxed);
+	}
+
+	uint64_t SubscriptionRegistry::hash_of(const StringRef& id)
+	{
+		// FNV-1a; 0 marks an empty slot
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < id.size(); i++)
+			hash = (hash ^ (unsigned char)id[i]) * 1099511628211ULL;
+		return hash ? hash : 1;
+	}
+
+	int SubscriptionRegistry::find_slot(const Table& slots, const StringRef& id, uint64_t hash)
+	{
+		size_t mask = slots.size() - 1;
+		size_t index;
+		if (slots.empty())
+			return -1;
+		for (index = hash & mask; slots[index].hash; index = (index + 1) & mask) {
+			if ((slots[index].hash == hash) && id.equals(slots[index].id))
+				return (int)index;
+		}
+		return -1;
+	}
+
+	void SubscriptionRegistry::rehash(const Table& from, Table& to, size_t capacity)
+	{
+		size_t mask = capacity - 1;
+		to.clear();
+		to.resize(capacity);
+		for (size_t i = 0; i < from.size(); i++) {
+			size_t index;
+			if (!from[i].hash)
+				continue;
+			for (index = from[i].hash & mask; to[index].hash; index = (index + 1) & mask) {}
+			to[index] = from[i];
+		}
+	}
+
+	void SubscriptionRegistry::add(const std::string& id, const std::shared_ptr<SubscriptionHandler>& handler)
+	{
+		// Declared before the lock: the old table (and handler) is released after unlocking
+		std::shared_ptr<const Table> current;
+		std::shared_ptr<Table> next;
+		std::unique_lock<std::mutex> lock(lock_);
+		uint64_t hash = hash_of(id);
+		size_t count = count_.load(std::memory_order_relaxed);
+		size_t mask;
+		size_t index;
+		int found;
+
+		current = table_;
+		next = std::make_shared<Table>();
+		found = find_slot(*current, id, hash);
+		if (found >= 0) {
+			*next = *current;
+			(*next)[found].handler = handler;
+			publish(next);
+			return;
+		}
+		// Keep the load factor at or below 1/2
+		if ((count + 1) * 2 > current->size())
+			rehash(*current, *next, current->empty() ? 16 : current->size() * 2);
+		else
+			*next = *current;
+		mask = next->size() - 1;
+		for (index = hash & mask; (*next)[index].hash; index = (index + 1) & mask) {}
+		(*next)[index].hash = hash;
+		(*next)[index].id = id;
+		(*next)[index].handler = handler;
+		publish(next);
+		count_.store(count + 1, std::memory_order_relaxed);
+	}
+
+	bool SubscriptionRegistry::remove(const StringRef& id)
+	{
+		// Declared before the lock: the old table (and handler) is released after unlocking
+		std::shared_ptr<const Table> current;
+		std::shared_ptr<Table> next;
+		std::unique_lock<std::mutex> lock(lock_);
+		size_t mask;
+		size_t hole;
+		size_t index;
+		int found;
+
+		current = table_;
+		found = find_slot(*current, id, hash_of(id));
+		if (found < 0)
+			return false;
+		next = std::make_shared<Table>(*current);
+		Table& slots = *next;
+		mask = slots.size() - 1;
+
+		// Backward-shift deletion: no tombstones, probe chains stay short
+		hole = (size_t)found;
+		for (index = (hole + 1) & mask; slots[index].hash; index = (index + 1) & mask) {
+			size_t home = slots[index].hash & mask;
+			// Move the entry into the hole unless its home lies cyclically in (hole, index]
+			bool stays = (hole <= index) ? ((hole < home) && (home <= index)) : ((hole < home) || (home <= index));
+			if (stays)
+				continue;
+			slots[hole].hash = slots[index].hash;
+			slots[hole].id.swap(slots[index].id);
+			slots[hole].handler.swap(slots[index].handler);
+			hole = index;
+		}
+		slots[hole].hash = 0;
+		slots[hole].id.clear();
+		slots[hole].handler.reset();
+		publish(next);
+		count_.store(count_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	void SubscriptionRegistry::clear()
+	{
+		std::shared_ptr<const Table> current;
+		{
+			std::unique_lock<std::mutex> lock(lock_);
+			current = table_;
+			publish(std::make_shared<Table>());
+			count_.store(0, std::memory_order_relaxed);
+		}
+		// Handlers are released outside the lock
+	}
+
+	/*
+	 * lock_ held.
+	 */
+	void SubscriptionRegistry::publish(const std::shared_ptr<const Table>& table)
+	{
+		table_ = table;
+		version_.fetch_add(1, std::memory_order_release);
+	}
+
+	/*
+	 * @return The calling thread's copy of the table, refreshed under lock_ if
+	 *         a writer published a new one since.
+	 */
+	const SubscriptionRegistry::Table* SubscriptionRegistry::snapshot() const
+	{
+		static thread_local std::vector<Snapshot> snapshots;
+		uint64_t version = version_.load(std::memory_order_acquire);
+		size_t i = 0;
+		while (i < snapshots.size()) {
+			Snapshot& item = snapshots[i];
+			if (item.live == live_) {
+				if (item.version != version) {
+					std::unique_lock<std::mutex> lock(lock_);
+					item.table = table_;
+					item.version = version_.load(std::memory_order_relaxed);
+				}
+				return item.table.get();
+			}
+			if (!item.live->load(std::memory_order_relaxed)) {
+				// Registry destroyed: release its table and handlers
+				item = std::move(snapshots.back());
+				snapshots.pop_back();
+				continue;
+			}
+			i++;
+		}
+		snapshots.push_back(Snapshot());
+		{
+			Snapshot& item = snapshots.back();
+			std::unique_lock<std::mutex> lock(lock_);
+			item.live = live_;
+			item.table = table_;
+			item.version = version_.load(std::memory_order_relaxed);
+			return item.table.get();
+		}
+	}
+
+	SubscriptionHandler* SubscriptionRegistry::find(const StringRef& id) const
+	{
+		const Table* table = snapshot();
+		int found = find_slot(*table, id, hash_of(id));
+		if (found < 0)
+			return NULL;
+		return (*table)[found].handler.get();
+	}
+
+}
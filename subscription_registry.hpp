@@ -0,0 +1,146 @@
+/**
+ * @file	subscription_registry.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "string_ref.hpp"
+#include "frame.hpp"
+#include "frame_view.hpp"
+
+namespace stomp {
+
+	/**
+	 * Receives the MESSAGE frames of one subscription.
+	 */
+	class SubscriptionHandler {
+	public:
+		virtual ~SubscriptionHandler() {}
+
+		virtual int onMessage(Frame* frame) = 0;
+		/**
+		 * Zero-copy delivery, the default materializes a Frame and calls onMessage.
+		 */
+		virtual int onMessageView(const FrameView& view) {
+			Frame frame;
+			view.to_frame(frame);
+			return onMessage(&frame);
+		}
+		/**
+		 * Streaming mode, see LibwebsocketsClient::setStreamingThreshold.
+		 */
+		virtual int onMessageStart(Frame* frame) { return 0; }
+		virtual int onMessageChunk(const char* data, int len, bool is_last) { return 0; }
+	};
+
+	/**
+	 * SubscriptionHandler calling a function for each (materialized) MESSAGE.
+	 */
+	class FunctionSubscriptionHandler : public SubscriptionHandler {
+	private:
+		std::function<int(Frame*)> function_;
+
+	public:
+		FunctionSubscriptionHandler(const std::function<int(Frame*)>& function)
+			: function_(function) {}
+
+		int onMessage(Frame* frame) override {
+			return function_(frame);
+		}
+	};
+
+	/**
+	 * Subscription id -> handler map consulted for every received MESSAGE.
+	 *
+	 * Open addressing with linear probing over a power-of-two table; lookups take
+	 * the id as a slice of the receive buffer and allocate nothing.
+	 *
+	 * The table is copy-on-write: add / remove copy it under the lock, publish
+	 * the copy and bump version_; subscribing is rare next to MESSAGE delivery.
+	 * Each thread keeps its own reference to the table it last used and only
+	 * takes the lock to refresh it when version_ changed, so find() is one
+	 * atomic load on the delivery path, without shared reference counting.
+	 * A handler stays alive until every thread that found it has looked up
+	 * this registry again (or exited), so one unregistered from another thread
+	 * outlives the delivery in progress.
+	 */
+	class SubscriptionRegistry {
+	private:
+		struct Slot {
+			// 0: empty
+			uint64_t hash;
+			std::string id;
+			std::shared_ptr<SubscriptionHandler> handler;
+		};
+
+		typedef std::vector<Slot> Table;
+
+		// A thread's reference to the table of one registry
+		struct Snapshot {
+			std::shared_ptr<std::atomic<bool> > live;
+			uint64_t version;
+			std::shared_ptr<const Table> table;
+		};
+
+		// Serializes writers and snapshot refreshes
+		mutable std::mutex lock_;
+		// Never modified once published
+		std::shared_ptr<const Table> table_;
+		std::atomic<uint64_t> version_;
+		// Identifies the registry in the per-thread snapshots; cleared by the destructor
+		std::shared_ptr<std::atomic<bool> > live_;
+		std::atomic<size_t> count_;
+
+		SubscriptionRegistry(const SubscriptionRegistry& o);
+		SubscriptionRegistry& operator=(const SubscriptionRegistry& o);
+
+		static uint64_t hash_of(const StringRef& id);
+		static int find_slot(const Table& slots, const StringRef& id, uint64_t hash);
+		static void rehash(const Table& from, Table& to, size_t capacity);
+
+		void publish(const std::shared_ptr<const Table>& table);
+		const Table* snapshot() const;
+
+	public:
+		SubscriptionRegistry();
+		~SubscriptionRegistry();
+
+		/**
+		 * Registers (or replaces) the handler of subscription id.
+		 */
+		void add(const std::string& id, const std::shared_ptr<SubscriptionHandler>& handler);
+		/**
+		 * @return true if id was registered
+		 */
+		bool remove(const StringRef& id);
+		void clear();
+
+		/**
+		 * @return Handler of id, NULL if none. Borrowed: valid until the calling
+		 *         thread looks this registry up again.
+		 */
+		SubscriptionHandler* find(const StringRef& id) const;
+
+		size_t size() const {
+			return count_.load(std::memory_order_relaxed);
+		}
+		bool empty() const {
+			return size() == 0;
+		}
+	};
+
+}
@@ -0,0 +1,863 @@
+/**
+ * @file	tcp_client.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "tcp_client.hpp"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "frame.hpp"
+
+#include "command/connect.hpp"
+#include "command/prepared_send.hpp"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+namespace stomp {
+
+	static const size_t max_iov = (IOV_MAX < 256) ? IOV_MAX : 256;
+
+	static int64_t steady_ticks()
+	{
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+	}
+
+	/*
+	 * Fills iov with the bytes of segments after the first skip bytes.
+	 * @return Bytes referenced by iov
+	 */
+	static size_t fill_iov(const Frame::PayloadSegment* segments, size_t count, size_t skip, std::vector<struct iovec>& iov)
+	{
+		size_t total = 0;
+		iov.clear();
+		for (size_t i = 0; (i < count) && (iov.size() < max_iov); i++) {
+			struct iovec item;
+			if (skip >= segments[i].size) {
+				skip -= segments[i].size;
+				continue;
+			}
+			item.iov_base = (void*)(segments[i].data + skip);
+			item.iov_len = segments[i].size - skip;
+			skip = 0;
+			total += item.iov_len;
+			iov.push_back(item);
+		}
+		return total;
+	}
+
+	TcpClient::TcpClient()
+		: Client(),
+		epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+		wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+		fd_(-1),
+		connect_pending_(false),
+		state_(State::DISCONNECTED),
+		stopping_(false),
+		frame_pool_(16),
+		receive_handler_(this),
+		receive_buffer_(get_receive_buffer_size()),
+		pending_offset_(0),
+		pending_bytes_(0),
+		pending_frames_(0),
+		want_write_(false),
+		send_queue_max_bytes_(0),
+		send_queue_max_frames_(0),
+		send_queue_low_bytes_(0),
+		send_queue_low_frames_(0),
+		send_queue_refused_(false),
+		id_tx_count_(0),
+		id_sub_count_(0),
+		heartbeat_cx_(10000),
+		heartbeat_cy_(10000),
+		heartbeat_send_interval_(0),
+		heartbeat_receive_interval_(0),
+		heartbeat_sent_ticks_(0),
+		timer_wheel_(std::chrono::microseconds(get_timer_period_us()), 64),
+		heartbeat_send_timer_(this, false),
+		heartbeat_receive_timer_(this, true)
+	{
+		struct epoll_event event;
+		frame_reader_.set_frame_pool(&frame_pool_);
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.fd = wake_fd_;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+	}
+
+	TcpClient::~TcpClient()
+	{
+		stopHeartbeat();
+		if (fd_ >= 0)
+			::close(fd_);
+		::close(wake_fd_);
+		::close(epoll_fd_);
+	}
+
+	int TcpClient::connect(const std::string& host, int port, const std::string& vhost)
+	{
+		struct addrinfo hints;
+		struct addrinfo* result = NULL;
+		struct epoll_event event;
+		char service[16];
+		int fd = -1;
+		int one = 1;
+
+		if (state_.load() != State::DISCONNECTED)
+			return -1;
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		snprintf(service, sizeof(service), "%d", port);
+		if (getaddrinfo(host.c_str(), service, &hints, &result) || !result)
+			return -1;
+		for (struct addrinfo* item = result; item; item = item->ai_next) {
+			fd = socket(item->ai_family, item->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, item->ai_protocol);
+			if (fd < 0)
+				continue;
+			// Frames are written whole: Nagle would only delay small ones
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			if (!::connect(fd, item->ai_addr, item->ai_addrlen) || (errno == EINPROGRESS))
+				break;
+			::close(fd);
+			fd = -1;
+		}
+		freeaddrinfo(result);
+		if (fd < 0)
+			return -1;
+
+		vhost_ = vhost;
+		frame_reader_.reset();
+		state_.store(State::CONNECTING);
+		{
+			std::unique_lock<std::mutex> lock(write_lock_);
+			connect_pending_ = true;
+			fd_ = fd;
+			want_write_ = true;
+		}
+		// Writable once the connection is up
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLOUT;
+		event.data.fd = fd;
+		if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event)) {
+			std::unique_lock<std::mutex> lock(write_lock_);
+			::close(fd_);
+			fd_ = -1;
+			connect_pending_ = false;
+			state_.store(State::DISCONNECTED);
+			return -1;
+		}
+		return 0;
+	}
+
+	void TcpClient::close()
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		if (fd_ >= 0)
+			shutdown(fd_, SHUT_RDWR);
+	}
+
+	int TcpClient::service(int timeout_ms)
+	{
+		struct epoll_event events[8];
+		int period_ms = get_timer_period_us() / 1000;
+		int count;
+		int i;
+
+		if (timer_wheel_.scheduled_count() && ((timeout_ms < 0) || (timeout_ms > period_ms)))
+			timeout_ms = period_ms;
+		count = epoll_wait(epoll_fd_, events, sizeof(events) / sizeof(events[0]), timeout_ms);
+		if (count < 0)
+			return (errno == EINTR) ? 0 : -1;
+
+		for (i = 0; i < count; i++) {
+			uint32_t flags = events[i].events;
+			if (events[i].data.fd == wake_fd_) {
+				uint64_t value;
+				while (read(wake_fd_, &value, sizeof(value)) > 0);
+				continue;
+			}
+			if (events[i].data.fd != fd_)
+				continue;
+
+			if (connect_pending_) {
+				onSocketConnected();
+				continue;
+			}
+			// Read before reacting to a hang-up: the peer's last frames (ERROR) come first
+			if ((flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) && (onSocketReadable() < 0)) {
+				closeSocket();
+				continue;
+			}
+			if (flags & EPOLLOUT) {
+				bool send_queue_low = false;
+				int rc;
+				{
+					std::unique_lock<std::mutex> lock(write_lock_);
+					rc = flushPending(send_queue_low);
+				}
+				if (rc < 0) {
+					closeSocket();
+					continue;
+				}
+				if (send_queue_low)
+					onSendQueueLow();
+			}
+		}
+
+		timer_wheel_.advance(std::chrono::steady_clock::now());
+		return count;
+	}
+
+	void TcpClient::run()
+	{
+		while (!stopping_.load()) {
+			if (service(-1) < 0)
+				break;
+		}
+		stopping_.store(false);
+	}
+
+	void TcpClient::stop()
+	{
+		uint64_t value = 1;
+		stopping_.store(true);
+		if (write(wake_fd_, &value, sizeof(value)) < 0) {
+			// Counter full: a wakeup is pending anyway
+		}
+	}
+
+	void TcpClient::onSocketConnected()
+	{
+		int error = 0;
+		socklen_t length = sizeof(error);
+		bool send_queue_low = false;
+		int rc;
+
+		if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length) || error) {
+			closeSocket();
+			return;
+		}
+		heartbeat_received_ticks_ = std::chrono::steady_clock::now();
+		sendConnectFrame();
+		{
+			std::unique_lock<std::mutex> lock(write_lock_);
+			connect_pending_ = false;
+			rc = flushPending(send_queue_low);
+			// Leaves the connect-time EPOLLOUT-only registration
+			if (rc == 0)
+				updateEvents(!pending_.empty());
+		}
+		if (rc < 0)
+			closeSocket();
+		else if (send_queue_low)
+			onSendQueueLow();
+	}
+
+	/*
+	 * Queued at the front: frames sent while connecting wait behind CONNECT.
+	 */
+	void TcpClient::sendConnectFrame()
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		Frame::PayloadSegment segment;
+		command::Connect connect(this);
+		if (!vhost_.empty())
+			connect.frame()->header(Frame::HEADER_HOST, vhost_);
+		write_head_.clear();
+		connect.frame()->make_payload_append(write_head_);
+		segment.data = &write_head_[0];
+		segment.size = write_head_.size();
+		queueRemainder(&segment, 1, 0, NULL, true);
+	}
+
+	int TcpClient::onSocketReadable()
+	{
+		for (;;) {
+			ssize_t length = read(fd_, &receive_buffer_[0], receive_buffer_.size());
+			if (length < 0) {
+				if (errno == EINTR)
+					continue;
+				return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+			}
+			if (length == 0)
+				return -1;
+			// Any received byte counts as a heart-beat
+			heartbeat_received_ticks_ = std::chrono::steady_clock::now();
+			frame_reader_.decode(&receive_buffer_[0], (int)length, &receive_handler_);
+			// Oversized frame: nothing after it can be parsed. Handler return
+			// codes do not close the connection.
+			if (frame_reader_.failed())
+				return -1;
+			// Level-triggered: a short read means the socket is drained for now
+			if ((size_t)length < receive_buffer_.size())
+				return 0;
+		}
+	}
+
+	void TcpClient::closeSocket()
+	{
+		{
+			std::unique_lock<std::mutex> lock(write_lock_);
+			if (fd_ < 0)
+				return;
+			epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd_, NULL);
+			::close(fd_);
+			fd_ = -1;
+			connect_pending_ = false;
+			want_write_ = false;
+			pending_.clear();
+			pending_offset_ = 0;
+			pending_bytes_.store(0);
+			pending_frames_.store(0);
+			send_space_cond_.notify_all();
+		}
+		frame_reader_.reset();
+		stopHeartbeat();
+		state_.store(State::DISCONNECTED);
+		receipts()->fail_all(ReceiptTable::RECEIPT_CLOSED);
+		onClosed();
+	}
+
+	/*
+	 * write_lock_ held.
+	 * @param owner Frame whose body segments[1] references; moved into the queue
+	 *              instead of copying the body if the write cannot complete.
+	 * @return SEND_OK, SEND_QUEUE_FULL or SEND_ERROR
+	 */
+	int TcpClient::writeSegments(const Frame::PayloadSegment* segments, size_t count, bool bounded, std::unique_ptr<Frame>* owner)
+	{
+		size_t total = 0;
+		size_t written = 0;
+		size_t queued;
+		size_t i;
+
+		if (fd_ < 0)
+			return SEND_ERROR;
+		for (i = 0; i < count; i++)
+			total += segments[i].size;
+		queued = pending_bytes_.load();
+		// An oversized frame still goes into an empty queue, or it could never be sent
+		if (bounded && ((send_queue_max_frames_ && (pending_.size() >= send_queue_max_frames_))
+			|| (send_queue_max_bytes_ && queued && (queued + total > send_queue_max_bytes_)))) {
+			send_queue_refused_ = true;
+			return SEND_QUEUE_FULL;
+		}
+
+		if (pending_.empty() && !connect_pending_) {
+			if (!writeDirect(segments, count, written))
+				return SEND_ERROR;
+			// A full socket buffer wrote nothing: still due for a heart-beat
+			if (written > 0)
+				heartbeat_sent_ticks_.store(steady_ticks(), std::memory_order_relaxed);
+		}
+		if (written < total) {
+			queueRemainder(segments, count, written, owner, false);
+			if (!want_write_)
+				updateEvents(true);
+		}
+		return SEND_OK;
+	}
+
+	/*
+	 * write_lock_ held. Writes until done or the socket buffer is full.
+	 * @param written In: bytes of segments already written, out: updated.
+	 * @return false on a socket error
+	 */
+	bool TcpClient::writeDirect(const Frame::PayloadSegment* segments, size_t count, size_t& written)
+	{
+		for (;;) {
+			struct msghdr message;
+			size_t requested = fill_iov(segments, count, written, write_iov_);
+			ssize_t rc;
+			if (!requested)
+				return true;
+			memset(&message, 0, sizeof(message));
+			message.msg_iov = &write_iov_[0];
+			message.msg_iovlen = write_iov_.size();
+			// sendmsg is writev with flags: no SIGPIPE on a closed peer
+			rc = sendmsg(fd_, &message, MSG_NOSIGNAL);
+			if (rc < 0) {
+				if (errno == EINTR)
+					continue;
+				return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+			}
+			written += (size_t)rc;
+			if ((size_t)rc < requested)
+				return true;
+		}
+	}
+
+	/*
+	 * write_lock_ held. Copies the unwritten part of segments into pending_,
+	 * except the body of owner, which is taken over.
+	 */
+	void TcpClient::queueRemainder(const Frame::PayloadSegment* segments, size_t count, size_t written, std::unique_ptr<Frame>* owner, bool front)
+	{
+		Frame::PayloadSegment remainder[3];
+		size_t remainder_count = 0;
+		size_t copy_size = 0;
+		size_t skip = written;
+		size_t i;
+
+		if (owner && (count == 3)) {
+			for (i = 0; i < count; i++) {
+				if (skip >= segments[i].size) {
+					skip -= segments[i].size;
+					continue;
+				}
+				remainder[remainder_count].data = segments[i].data + skip;
+				remainder[remainder_count].size = segments[i].size - skip;
+				skip = 0;
+				if (i != 1)
+					copy_size += remainder[remainder_count].size;
+				remainder_count++;
+			}
+		}
+		else {
+			// Flattened into one copied segment
+			for (i = 0; i < count; i++)
+				copy_size += segments[i].size;
+			copy_size -= written;
+		}
+
+		if (front)
+			pending_.emplace_front();
+		else
+			pending_.emplace_back();
+		PendingWrite& item = front ? pending_.front() : pending_.back();
+		// Reserved up front: the segments point into data
+		item.data.reserve(copy_size);
+		item.segment_count = 0;
+		item.size = 0;
+
+		if (owner && (count == 3)) {
+			const char* body = segments[1].data;
+			const char* body_end = body + segments[1].size;
+			item.frame = std::move(*owner);
+			for (i = 0; i < remainder_count; i++) {
+				Frame::PayloadSegment& segment = item.segments[item.segment_count++];
+				if ((remainder[i].data >= body) && (remainder[i].data < body_end)) {
+					// std::string storage is left in place by the move of its Frame
+					segment = remainder[i];
+				}
+				else {
+					size_t offset = item.data.size();
+					item.data.insert(item.data.end(), remainder[i].data, remainder[i].data + remainder[i].size);
+					segment.data = &item.data[offset];
+					segment.size = remainder[i].size;
+				}
+				item.size += segment.size;
+			}
+		}
+		else {
+			skip = written;
+			for (i = 0; i < count; i++) {
+				if (skip >= segments[i].size) {
+					skip -= segments[i].size;
+					continue;
+				}
+				item.data.insert(item.data.end(), segments[i].data + skip, segments[i].data + segments[i].size);
+				skip = 0;
+			}
+			item.segments[0].data = item.data.empty() ? NULL : &item.data[0];
+			item.segments[0].size = item.data.size();
+			item.segment_count = 1;
+			item.size = item.data.size();
+		}
+		pending_bytes_.fetch_add(item.size);
+		pending_frames_.fetch_add(1);
+	}
+
+	/*
+	 * write_lock_ held; service thread.
+	 * @param send_queue_low Set if onSendQueueLow is due (called after unlocking).
+	 * @return 0, or -1 on a socket error
+	 */
+	int TcpClient::flushPending(bool& send_queue_low)
+	{
+		size_t written = pending_offset_;
+		bool progressed = false;
+
+		while (!pending_.empty()) {
+			size_t batch_size = 0;
+			size_t before = written;
+			bool complete;
+			write_segments_.clear();
+			for (std::deque<PendingWrite>::iterator iter = pending_.begin(); (iter != pending_.end()) && (write_segments_.size() < max_iov); iter++) {
+				write_segments_.insert(write_segments_.end(), iter->segments, iter->segments + iter->segment_count);
+				batch_size += iter->size;
+			}
+			if (!writeDirect(&write_segments_[0], write_segments_.size(), written))
+				return -1;
+			complete = (written == batch_size);
+			if (written != before) {
+				progressed = true;
+				pending_bytes_.fetch_sub(written - before);
+			}
+			// Drop the entries that went out completely
+			while (!pending_.empty() && (written >= pending_.front().size)) {
+				written -= pending_.front().size;
+				pending_.pop_front();
+				pending_frames_.fetch_sub(1);
+			}
+			if (!complete)
+				break;
+		}
+		pending_offset_ = written;
+		if (progressed)
+			heartbeat_sent_ticks_.store(steady_ticks(), std::memory_order_relaxed);
+
+		if (pending_.empty() && want_write_)
+			updateEvents(false);
+		send_space_cond_.notify_all();
+		if (send_queue_refused_ && (pending_bytes_.load() <= send_queue_low_bytes_) && (pending_.size() <= send_queue_low_frames_)) {
+			send_queue_refused_ = false;
+			send_queue_low = true;
+		}
+		return 0;
+	}
+
+	/*
+	 * write_lock_ held.
+	 */
+	void TcpClient::updateEvents(bool want_write)
+	{
+		struct epoll_event event;
+		if (connect_pending_)
+			return;
+		memset(&event, 0, sizeof(event));
+		event.events = want_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+		event.data.fd = fd_;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd_, &event);
+		want_write_ = want_write;
+	}
+
+	int TcpClient::ReceiveHandler::onFrame(Frame* frame)
+	{
+		switch (frame->command_id()) {
+		case Frame::COMMAND_CONNECTED:
+			return client_->onFrameConnected(frame);
+		case Frame::COMMAND_MESSAGE:
+			return client_->dispatchMessage(frame);
+		case Frame::COMMAND_RECEIPT:
+			client_->receipts()->complete(frame->header(Frame::HEADER_RECEIPT_ID), ReceiptTable::RECEIPT_OK);
+			return 0;
+		case Frame::COMMAND_ERROR:
+			return client_->onFrameError(frame);
+		default:
+			return 0;
+		}
+	}
+
+	int TcpClient::ReceiveHandler::onFrameView(const FrameView& view)
+	{
+		switch (view.command_id()) {
+		case Frame::COMMAND_MESSAGE:
+			return client_->dispatchMessageView(view);
+		case Frame::COMMAND_RECEIPT:
+			client_->receipts()->complete(view.header("receipt-id"), ReceiptTable::RECEIPT_OK);
+			return 0;
+		case Frame::COMMAND_CONNECTED:
+		case Frame::COMMAND_ERROR:
+			return FrameHandler::onFrameView(view);
+		default:
+			return 0;
+		}
+	}
+
+	int TcpClient::ReceiveHandler::onFrameHeaders(Frame* frame)
+	{
+		if (frame->command_id() != Frame::COMMAND_MESSAGE)
+			return 0;
+		if (!client_->subscriptions()->empty()) {
+			SubscriptionHandler* handler = client_->subscriptions()->find(frame->subscription());
+			if (handler)
+				return handler->onMessageStart(frame);
+		}
+		return client_->onMessageStart(frame);
+	}
+
+	int TcpClient::ReceiveHandler::onFrameChunk(Frame* frame, const char* data, int len, bool is_last)
+	{
+		if (frame->command_id() != Frame::COMMAND_MESSAGE)
+			return 0;
+		if (!client_->subscriptions()->empty()) {
+			SubscriptionHandler* handler = client_->subscriptions()->find(frame->subscription());
+			if (handler)
+				return handler->onMessageChunk(data, len, is_last);
+		}
+		return client_->onMessageChunk(frame->subscription(), data, len, is_last);
+	}
+
+	int TcpClient::onFrameConnected(Frame* frame)
+	{
+		int heartbeat_sx = 0;
+		int heartbeat_sy = 0;
+		if (frame->has_header(Frame::HEADER_HEART_BEAT)) {
+			const std::string& heart_beat = frame->header(Frame::HEADER_HEART_BEAT);
+			if (sscanf(heart_beat.c_str(), "%d,%d", &heartbeat_sx, &heartbeat_sy) != 2)
+				heartbeat_sx = heartbeat_sy = 0;
+		}
+		// STOMP 1.1: no heart-beats in a direction where either side offers 0
+		heartbeat_send_interval_ = ((heartbeat_cx_ > 0) && (heartbeat_sy > 0)) ? ((heartbeat_cx_ > heartbeat_sy) ? heartbeat_cx_ : heartbeat_sy) : 0;
+		heartbeat_receive_interval_ = ((heartbeat_cy_ > 0) && (heartbeat_sx > 0)) ? ((heartbeat_cy_ > heartbeat_sx) ? heartbeat_cy_ : heartbeat_sx) : 0;
+
+		state_.store(State::CONNECTED);
+		startHeartbeat();
+
+		return onConnected(frame);
+	}
+
+	int TcpClient::onFrameError(Frame* frame)
+	{
+		if (frame->has_header(Frame::HEADER_RECEIPT_ID))
+			receipts()->complete(frame->header(Frame::HEADER_RECEIPT_ID), ReceiptTable::RECEIPT_ERROR, frame->header(Frame::HEADER_MESSAGE));
+		return onError(frame);
+	}
+
+	void TcpClient::startHeartbeat()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		heartbeat_sent_ticks_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+		heartbeat_received_ticks_ = now;
+		if (heartbeat_send_interval_ > 0)
+			timer_wheel_.schedule(&heartbeat_send_timer_, now + std::chrono::milliseconds(heartbeat_send_interval_));
+		if (heartbeat_receive_interval_ > 0)
+			onHeartbeatReceiveTimer();
+	}
+
+	void TcpClient::stopHeartbeat()
+	{
+		timer_wheel_.cancel(&heartbeat_send_timer_);
+		timer_wheel_.cancel(&heartbeat_receive_timer_);
+	}
+
+	void TcpClient::HeartbeatTimer::onTimer()
+	{
+		if (receive_)
+			client_->onHeartbeatReceiveTimer();
+		else
+			client_->onHeartbeatSendTimer();
+	}
+
+	/*
+	 * Deadlines are checked lazily: traffic only moves the timestamps, the timer
+	 * re-arms itself from them when it fires.
+	 */
+	void TcpClient::onHeartbeatSendTimer()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point sent(std::chrono::steady_clock::duration(heartbeat_sent_ticks_.load(std::memory_order_relaxed)));
+		std::chrono::steady_clock::time_point due = sent + std::chrono::milliseconds(heartbeat_send_interval_);
+
+		if ((state_.load() != State::CONNECTED) || (heartbeat_send_interval_ <= 0))
+			return;
+
+		if (now >= due) {
+			static const char eol[1] = { '\n' };
+			Frame::PayloadSegment segment;
+			segment.data = eol;
+			segment.size = 1;
+			{
+				std::unique_lock<std::mutex> lock(write_lock_);
+				writeSegments(&segment, 1, false);
+			}
+			heartbeat_sent_ticks_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+			due = now + std::chrono::milliseconds(heartbeat_send_interval_);
+		}
+		timer_wheel_.schedule(&heartbeat_send_timer_, due);
+	}
+
+	void TcpClient::onHeartbeatReceiveTimer()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::milliseconds timeout(heartbeat_receive_interval_ + heartbeat_receive_interval_ * get_heartbeat_grace_percent() / 100);
+		std::chrono::steady_clock::time_point deadline = heartbeat_received_ticks_ + timeout;
+
+		if (heartbeat_receive_interval_ <= 0)
+			return;
+
+		if (now < deadline) {
+			timer_wheel_.schedule(&heartbeat_receive_timer_, deadline);
+			return;
+		}
+
+		// Half-open or dead peer
+		stopHeartbeat();
+		onHeartbeatTimeout();
+		closeSocket();
+	}
+
+	void TcpClient::setStreamingThreshold(int threshold)
+	{
+		frame_reader_.set_streaming_threshold(threshold);
+	}
+
+	void TcpClient::setMaxFrameSize(size_t bytes)
+	{
+		frame_reader_.set_max_frame_size(bytes);
+	}
+
+	void TcpClient::setSendQueueLimits(size_t max_bytes, size_t max_frames, size_t low_water_bytes, size_t low_water_frames)
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		send_queue_max_bytes_ = max_bytes;
+		send_queue_max_frames_ = max_frames;
+		send_queue_low_bytes_ = low_water_bytes ? low_water_bytes : (max_bytes ? max_bytes / 2 : (size_t)-1);
+		send_queue_low_frames_ = low_water_frames ? low_water_frames : (max_frames ? max_frames / 2 : (size_t)-1);
+	}
+
+	size_t TcpClient::sendQueueBytes() const
+	{
+		return pending_bytes_.load(std::memory_order_relaxed);
+	}
+
+	size_t TcpClient::sendQueueFrames() const
+	{
+		return pending_frames_.load(std::memory_order_relaxed);
+	}
+
+	Client::State TcpClient::state() const
+	{
+		return state_.load();
+	}
+
+	/*
+	 * write_lock_ held.
+	 */
+	int TcpClient::sendFrameLocked(Frame* frame, bool bounded)
+	{
+		Frame::PayloadSegment segments[3];
+		int count;
+		write_head_.clear();
+		count = frame->make_payload_segments(write_head_, segments);
+		return writeSegments(segments, count, bounded);
+	}
+
+	int TcpClient::sendFrame(Frame* frame)
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		return sendFrameLocked(frame, false);
+	}
+
+	int TcpClient::sendFrame(std::unique_ptr<Frame> frame)
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		Frame::PayloadSegment segments[3];
+		int count;
+		write_head_.clear();
+		count = frame->make_payload_segments(write_head_, segments);
+		return writeSegments(segments, count, false, &frame);
+	}
+
+	int TcpClient::trySendFrame(Frame* frame)
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		return sendFrameLocked(frame, true);
+	}
+
+	int TcpClient::sendFrame(Frame* frame, int timeout_ms)
+	{
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+		std::unique_lock<std::mutex> lock(write_lock_);
+		for (;;) {
+			int rc = sendFrameLocked(frame, true);
+			if (rc != SEND_QUEUE_FULL)
+				return rc;
+			if (timeout_ms < 0) {
+				send_space_cond_.wait(lock);
+			}
+			else if (send_space_cond_.wait_until(lock, deadline) == std::cv_status::timeout) {
+				rc = sendFrameLocked(frame, true);
+				return (rc == SEND_QUEUE_FULL) ? SEND_TIMEOUT : rc;
+			}
+		}
+	}
+
+	int TcpClient::sendFrames(Frame* const* frames, size_t count)
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		size_t head_size = 0;
+		size_t used = 0;
+		size_t i;
+		if (!count)
+			return SEND_OK;
+		for (i = 0; i < count; i++)
+			head_size += frames[i]->header_block_size();
+		write_head_.clear();
+		// Reserved up front: the segments point into write_head_
+		write_head_.reserve(head_size);
+		write_segments_.resize(count * 3);
+		for (i = 0; i < count; i++)
+			used += frames[i]->make_payload_segments(write_head_, &write_segments_[used]);
+		return writeSegments(&write_segments_[0], used, false);
+	}
+
+	int TcpClient::sendCommand(command::Base* item)
+	{
+		return sendFrame(item->frame());
+	}
+
+	int TcpClient::sendPrepared(const command::PreparedSend* prepared, const char* body, size_t body_length)
+	{
+		std::unique_lock<std::mutex> lock(write_lock_);
+		Frame::PayloadSegment segment;
+		write_head_.clear();
+		prepared->make_payload_append(body, body_length, write_head_);
+		segment.data = &write_head_[0];
+		segment.size = write_head_.size();
+		return writeSegments(&segment, 1, true);
+	}
+
+	std::string TcpClient::generateSubscribeId()
+	{
+		std::unique_lock<std::mutex> lock{ id_lock_ };
+		char buf[128];
+		snprintf(buf, sizeof(buf), "sub-%llx", (unsigned long long)++id_sub_count_);
+		return buf;
+	}
+
+	std::string TcpClient::generateTransactionId()
+	{
+		std::unique_lock<std::mutex> lock{ id_lock_ };
+		char buf[128];
+		snprintf(buf, sizeof(buf), "tx-%llx", (unsigned long long)++id_tx_count_);
+		return buf;
+	}
+
+	int TcpClient::get_receive_buffer_size() {
+		return 65536;
+	}
+
+	int TcpClient::get_timer_period_us() {
+		return 100000;
+	}
+
+	int TcpClient::get_heartbeat_grace_percent() {
+		return 50;
+	}
+
+}
+
+#endif /* __linux__ */
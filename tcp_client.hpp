@@ -0,0 +1,249 @@
+/**
+ * @file	tcp_client.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#if defined(__linux__)
+
+#include "client.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "frame_reader.hpp"
+#include "frame_pool.hpp"
+#include "timer_wheel.hpp"
+
+namespace stomp {
+
+	/**
+	 * STOMP over a plain TCP connection (e.g. port 61613), without WebSocket
+	 * framing.
+	 *
+	 * One thread drives the connection with service() or run(). Sends may come
+	 * from any thread: a sender writes the frame straight to the non-blocking
+	 * socket with scatter-gather I/O (header block, body, NUL), and only what the
+	 * kernel did not take is copied into the pending queue, which the service
+	 * thread writes out on EPOLLOUT.
+	 */
+	class TcpClient : public Client {
+	public:
+		static int get_receive_buffer_size();
+		static int get_timer_period_us();
+		static int get_heartbeat_grace_percent();
+
+	private:
+		class ReceiveHandler : public FrameHandler {
+		private:
+			TcpClient* client_;
+
+		public:
+			ReceiveHandler(TcpClient* client)
+				: client_(client) {}
+
+			int onFrame(Frame* frame) override;
+			int onFrameView(const FrameView& view) override;
+			int onFrameHeaders(Frame* frame) override;
+			int onFrameChunk(Frame* frame, const char* data, int len, bool is_last) override;
+		};
+
+		class HeartbeatTimer : public TimerWheel::Timer {
+		private:
+			TcpClient* client_;
+			bool receive_;
+
+		public:
+			HeartbeatTimer(TcpClient* client, bool receive)
+				: client_(client), receive_(receive) {}
+
+			void onTimer() override;
+		};
+
+		/**
+		 * Unwritten bytes of one send. segments point into data, or into the body
+		 * of frame for sendFrame(std::unique_ptr<Frame>).
+		 */
+		struct PendingWrite {
+			std::vector<char> data;
+			std::unique_ptr<Frame> frame;
+			Frame::PayloadSegment segments[3];
+			int segment_count;
+			size_t size;
+		};
+
+		int epoll_fd_;
+		// eventfd for stop()
+		int wake_fd_;
+		// Socket; changed under write_lock_
+		std::atomic<int> fd_;
+		// Non-blocking connect() in progress; changed under write_lock_
+		std::atomic<bool> connect_pending_;
+		std::atomic<State> state_;
+		std::atomic<bool> stopping_;
+		std::string vhost_;
+
+		FramePool frame_pool_;
+		FrameReader frame_reader_;
+		ReceiveHandler receive_handler_;
+		std::vector<char> receive_buffer_;
+
+		// Socket writes, pending_ and the scratch vectors below
+		std::mutex write_lock_;
+		std::deque<PendingWrite> pending_;
+		// Bytes of pending_.front() already written
+		size_t pending_offset_;
+		std::atomic<size_t> pending_bytes_;
+		// Entries of pending_: one per queued frame or sendFrames batch
+		std::atomic<size_t> pending_frames_;
+		// EPOLLOUT is registered
+		bool want_write_;
+		std::vector<char> write_head_;
+		std::vector<Frame::PayloadSegment> write_segments_;
+		std::vector<struct iovec> write_iov_;
+
+		// Limits for bounded sends, 0 for none
+		size_t send_queue_max_bytes_;
+		size_t send_queue_max_frames_;
+		size_t send_queue_low_bytes_;
+		size_t send_queue_low_frames_;
+		// Set when a bounded send was refused, cleared with onSendQueueLow()
+		bool send_queue_refused_;
+		// Waited on with write_lock_
+		std::condition_variable send_space_cond_;
+
+		std::mutex id_lock_;
+		int64_t id_tx_count_;
+		int64_t id_sub_count_;
+
+		int heartbeat_cx_;
+		int heartbeat_cy_;
+		int heartbeat_send_interval_;
+		int heartbeat_receive_interval_;
+		// steady_clock ticks of the last write, written by any sending thread
+		std::atomic<int64_t> heartbeat_sent_ticks_;
+		// Last received bytes, service thread only
+		std::chrono::steady_clock::time_point heartbeat_received_ticks_;
+		TimerWheel timer_wheel_;
+		HeartbeatTimer heartbeat_send_timer_;
+		HeartbeatTimer heartbeat_receive_timer_;
+
+		TcpClient(const TcpClient& o);
+		TcpClient& operator=(const TcpClient& o);
+
+		int sendFrameLocked(Frame* frame, bool bounded);
+		int writeSegments(const Frame::PayloadSegment* segments, size_t count, bool bounded, std::unique_ptr<Frame>* owner = NULL);
+		bool writeDirect(const Frame::PayloadSegment* segments, size_t count, size_t& written);
+		void queueRemainder(const Frame::PayloadSegment* segments, size_t count, size_t written, std::unique_ptr<Frame>* owner, bool front);
+		int flushPending(bool& send_queue_low);
+		void updateEvents(bool want_write);
+		void sendConnectFrame();
+
+		void onSocketConnected();
+		int onSocketReadable();
+		void closeSocket();
+
+		int onFrameConnected(Frame* frame);
+		int onFrameError(Frame* frame);
+		void startHeartbeat();
+		void stopHeartbeat();
+		void onHeartbeatSendTimer();
+		void onHeartbeatReceiveTimer();
+
+	public:
+		TcpClient();
+		/**
+		 * Closes the socket without calling onClosed.
+		 */
+		virtual ~TcpClient();
+
+		/**
+		 * Starts a non-blocking connect to host:port; CONNECT is sent by the
+		 * service thread once the socket is up. host is resolved on the calling
+		 * thread. vhost goes into the host header of CONNECT.
+		 * @return 0, or -1 if resolving / connecting failed or a socket is open
+		 */
+		int connect(const std::string& host, int port, const std::string& vhost = std::string());
+		/**
+		 * Shuts the connection down from any thread; the service thread then
+		 * closes the socket and calls onClosed.
+		 */
+		void close();
+
+		/**
+		 * Waits up to timeout_ms (negative: no limit) for socket events and
+		 * handles them. Heart-beats cap the wait at the timer period.
+		 * @return Number of events, negative on epoll failure
+		 */
+		int service(int timeout_ms);
+		/**
+		 * Calls service() until stop().
+		 */
+		void run();
+		void stop();
+
+		/**
+		 * MESSAGE frames with a content-length above threshold bytes are delivered
+		 * through onMessageStart / onMessageChunk. 0 (default) disables streaming.
+		 */
+		void setStreamingThreshold(int threshold);
+
+		/**
+		 * Largest received frame that is buffered, see FrameReader::set_max_frame_size;
+		 * a bigger one closes the connection.
+		 */
+		void setMaxFrameSize(size_t bytes);
+
+		/**
+		 * Limits on unwritten data for trySendFrame, sendFrame(frame, timeout_ms)
+		 * and sendPrepared, as LibwebsocketsClient::setSendQueueLimits. Other
+		 * sends are always queued but still count. Only what the socket did not
+		 * take counts; a sendFrames batch is one frame.
+		 * A frame larger than max_bytes is accepted into an empty queue.
+		 * 0 disables a limit; low-water marks of 0 default to half the limit.
+		 */
+		void setSendQueueLimits(size_t max_bytes, size_t max_frames = 0, size_t low_water_bytes = 0, size_t low_water_frames = 0);
+		size_t sendQueueBytes() const;
+		size_t sendQueueFrames() const;
+
+		State state() const override;
+
+		int sendFrame(Frame* frame) override;
+		/**
+		 * The body is referenced instead of copied if the write has to be queued.
+		 */
+		int sendFrame(std::unique_ptr<Frame> frame) override;
+		int trySendFrame(Frame* frame) override;
+		/**
+		 * Must not be called from the service thread, which is the one draining the queue.
+		 */
+		int sendFrame(Frame* frame, int timeout_ms) override;
+		/**
+		 * Writes the frames with one gathered write.
+		 */
+		int sendFrames(Frame* const* frames, size_t count) override;
+		int sendCommand(command::Base* item) override;
+		int sendPrepared(const command::PreparedSend* prepared, const char* body, size_t body_length) override;
+
+		std::string generateSubscribeId() override;
+		std::string generateTransactionId() override;
+	};
+
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,154 @@
+/**
+ * @file	frame_reader_test.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ *
+ * FrameReader: the bench corpus and generated frames must decode to the same
+ * frames whole and split at any size, and survive an encode/decode round trip.
+ */
+#include "test_util.hpp"
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "frame_reader.hpp"
+
+using namespace stomp;
+
+namespace {
+
+	const size_t kChunkSizes[] = { 1, 2, 7, 64, 1460 };
+
+	std::string encode(const test::FrameList& frames) {
+		std::vector<char> payload;
+		for (test::FrameList::const_iterator iter = frames.begin(); iter != frames.end(); iter++)
+			(*iter)->make_payload_append(payload);
+		return std::string(payload.begin(), payload.end());
+	}
+
+	void check_splits(const std::string& name, const std::string& data, const test::FrameList& expected) {
+		for (size_t i = 0; i < sizeof(kChunkSizes) / sizeof(kChunkSizes[0]); i++) {
+			test::FrameList frames;
+			if (!test::decode_split(data, kChunkSizes[i], frames)) {
+				fprintf(stderr, "%s: decode failed at chunk size %d\n", name.c_str(), (int)kChunkSizes[i]);
+				test::failures()++;
+				continue;
+			}
+			STOMP_CHECK_SAME(test::compare(frames, expected));
+		}
+	}
+
+	void test_corpus(const char* file_name, size_t min_frames) {
+		std::string path = std::string(STOMP_TEST_CORPUS_DIR) + "/" + file_name;
+		std::string data;
+		test::FrameList whole;
+		test::FrameList round_trip;
+
+		if (!test::read_file(path, data)) {
+			fprintf(stderr, "cannot read %s\n", path.c_str());
+			test::failures()++;
+			return;
+		}
+		STOMP_CHECK(test::decode_split(data, 0, whole));
+		STOMP_CHECK(whole.size() >= min_frames);
+		check_splits(file_name, data, whole);
+
+		// Re-encoding escapes the decoded headers again
+		STOMP_CHECK(test::decode_split(encode(whole), 0, round_trip));
+		STOMP_CHECK_SAME(test::compare(round_trip, whole));
+	}
+
+	void test_generated() {
+		test::FrameList frames;
+		std::string data;
+		unsigned int seed = 1;
+
+		for (int i = 0; i < 40; i++) {
+			std::unique_ptr<Frame> frame(new Frame(Frame::Commands::MESSAGE));
+			std::string body;
+			int body_length = (i * 37) % 300;
+			frame->header(Frame::HEADER_SUBSCRIPTION, "sub-" + std::to_string(i % 3));
+			frame->header("x-escaped", (i % 2) ? "a:b\\c\r\nd" : "plain");
+			frame->header("x-empty", "");
+			for (int j = 0; j < body_length; j++) {
+				seed = seed * 1103515245 + 12345;
+				body.push_back((char)(seed >> 16));
+			}
+			if (i % 4) {
+				// Binary bodies need content-length; the rest stop at the NUL
+				frame->header(Frame::HEADER_CONTENT_LENGTH, std::to_string(body.size()));
+			}
+			else {
+				for (size_t j = 0; j < body.size(); j++) {
+					if (!body[j])
+						body[j] = 'z';
+				}
+			}
+			frame->body(body);
+			frames.emplace_back(std::move(frame));
+			if (i % 5 == 0)
+				data.append("\n\r\n");
+		}
+		data.append(encode(frames));
+		check_splits("generated", data, frames);
+	}
+
+	void test_colon_split() {
+		static const char data[] = "MESSAGE\nx-url:http://host:80/a\nx-none\nx-colon::\n\nbody";
+		std::string frame_data(data, sizeof(data));
+		test::FrameList whole;
+
+		STOMP_CHECK(test::decode_split(frame_data, 0, whole));
+		STOMP_CHECK_EQ(whole.size(), (size_t)1);
+		if (whole.empty())
+			return;
+		STOMP_CHECK_EQ(whole.front()->header("x-url"), std::string("http://host:80/a"));
+		STOMP_CHECK(whole.front()->has_header("x-none"));
+		STOMP_CHECK_EQ(whole.front()->header("x-none"), std::string(""));
+		STOMP_CHECK_EQ(whole.front()->header("x-colon"), std::string(":"));
+		check_splits("colon", frame_data, whole);
+	}
+
+	void test_max_frame_size() {
+		static const char by_length[] = "SEND\ncontent-length:100\n\n";
+		static const char by_nul[] = "SEND\n\n0123456789abcdef";
+		static const char ok[] = "SEND\ncontent-length:4\n\nfour";
+		const char* oversized[] = { by_length, by_nul };
+
+		for (size_t i = 0; i < sizeof(oversized) / sizeof(oversized[0]); i++) {
+			FrameReader reader;
+			test::FrameList frames;
+			std::string data(oversized[i]);
+			reader.set_max_frame_size(32);
+			data.append(200, 'x');
+			data.push_back(0);
+			STOMP_CHECK_EQ(reader.decode(data.data(), (int)data.size(), frames), -1);
+			STOMP_CHECK(reader.failed());
+			STOMP_CHECK(frames.empty());
+			reader.reset();
+			STOMP_CHECK(!reader.failed());
+			STOMP_CHECK_EQ(reader.decode(ok, sizeof(ok), frames), 0);
+			STOMP_CHECK_EQ(frames.size(), (size_t)1);
+		}
+	}
+
+}
+
+int main() {
+	test_corpus("small_json.stomp", 1);
+	test_corpus("escaped_headers.stomp", 1);
+	test_corpus("large_binary.stomp", 1);
+	test_corpus("heartbeats.stomp", 1);
+	test_generated();
+	test_colon_split();
+	test_max_frame_size();
+	if (stomp::test::failures()) {
+		fprintf(stderr, "%d check(s) failed\n", stomp::test::failures());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file	frame_test.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ *
+ * Frame encoding: header escaping, header classification and serialization.
+ */
+#include "test_util.hpp"
+
+#include <string.h>
+
+#include <vector>
+
+using namespace stomp;
+
+namespace {
+
+	void test_header_escape() {
+		static const struct {
+			const char* raw;
+			const char* encoded;
+		} cases[] = {
+			{ "", "" },
+			{ "plain", "plain" },
+			{ "a:b", "a\\cb" },
+			{ "line\nbreak", "line\\nbreak" },
+			{ "carriage\rreturn", "carriage\\rreturn" },
+			{ "back\\slash", "back\\\\slash" },
+			{ ":\n\r\\", "\\c\\n\\r\\\\" },
+			{ "\xed\x95\x9c\xea\xb8\x80:utf-8", "\xed\x95\x9c\xea\xb8\x80\\cutf-8" },
+		};
+		for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+			std::string raw(cases[i].raw);
+			std::string encoded(cases[i].encoded);
+			std::vector<char> appended;
+			std::string inplace(encoded);
+
+			STOMP_CHECK_EQ(Frame::header_encode(raw), encoded);
+			STOMP_CHECK_EQ(Frame::header_decode(encoded), raw);
+			STOMP_CHECK_EQ(Frame::header_encoded_size(raw.data(), raw.size()), encoded.size());
+			Frame::header_encode_append(raw.data(), raw.size(), appended);
+			STOMP_CHECK_EQ(std::string(appended.begin(), appended.end()), encoded);
+			inplace.resize(Frame::header_decode_inplace(&inplace[0], inplace.size()));
+			STOMP_CHECK_EQ(inplace, raw);
+		}
+	}
+
+	void test_header_escape_long() {
+		// Long enough for the vector kernels, with escapes at every offset
+		for (size_t position = 0; position < 80; position++) {
+			std::string raw(80, 'x');
+			raw[position] = (position % 2) ? ':' : '\n';
+			std::string encoded = Frame::header_encode(raw);
+			STOMP_CHECK_EQ(encoded.size(), raw.size() + 1);
+			STOMP_CHECK_EQ(Frame::header_encoded_size(raw.data(), raw.size()), encoded.size());
+			STOMP_CHECK_EQ(Frame::header_decode(encoded), raw);
+		}
+	}
+
+	void test_header_id() {
+		STOMP_CHECK_EQ(Frame::header_id("content-length", 14), Frame::HEADER_CONTENT_LENGTH);
+		STOMP_CHECK_EQ(Frame::header_id("Content-Length", 14), Frame::HEADER_CONTENT_LENGTH);
+		STOMP_CHECK_EQ(Frame::header_id("destination", 11), Frame::HEADER_DESTINATION);
+		STOMP_CHECK_EQ(Frame::header_id("x-custom", 8), Frame::HEADER_UNKNOWN);
+		STOMP_CHECK_EQ(Frame::header_id("", 0), Frame::HEADER_UNKNOWN);
+		for (int id = 0; id < Frame::HEADER_KNOWN_COUNT; id++) {
+			const char* name = Frame::header_name((Frame::HeaderId)id);
+			STOMP_CHECK_EQ(Frame::header_id(name, strlen(name)), (Frame::HeaderId)id);
+		}
+		STOMP_CHECK_EQ(Frame::command_id("SEND", 4), Frame::COMMAND_SEND);
+		STOMP_CHECK_EQ(Frame::command_id("send", 4), Frame::COMMAND_UNKNOWN);
+	}
+
+	void test_headers() {
+		Frame frame(Frame::Commands::SEND);
+		frame.header(Frame::HEADER_DESTINATION, "/queue/a");
+		// First occurrence wins
+		frame.header("Destination", "/queue/b");
+		frame.header("x-custom", "1");
+		STOMP_CHECK_EQ(frame.destination(), std::string("/queue/a"));
+		STOMP_CHECK_EQ(frame.header_count(), (size_t)2);
+		STOMP_CHECK_EQ(frame.header("X-Custom"), std::string("1"));
+		STOMP_CHECK(!frame.has_header(Frame::HEADER_RECEIPT));
+
+		frame.replace_header(Frame::HEADER_DESTINATION, "/queue/longer-name");
+		frame.replace_header(Frame::HEADER_RECEIPT, "r-1");
+		STOMP_CHECK_EQ(frame.destination(), std::string("/queue/longer-name"));
+		STOMP_CHECK_EQ(frame.header(Frame::HEADER_RECEIPT), std::string("r-1"));
+		STOMP_CHECK_EQ(frame.header_count(), (size_t)3);
+
+		frame.clear();
+		STOMP_CHECK_EQ(frame.header_count(), (size_t)0);
+		STOMP_CHECK(!frame.has_header(Frame::HEADER_DESTINATION));
+	}
+
+	void test_serialize() {
+		Frame frame(Frame::Commands::SEND);
+		std::vector<char> payload;
+		std::vector<char> head;
+		std::vector<char> gathered;
+		Frame::PayloadSegment segments[3];
+		int count;
+
+		frame.header(Frame::HEADER_DESTINATION, "/queue/a");
+		frame.header("x-escaped", "a:b\nc");
+		frame.replace_header(Frame::HEADER_DESTINATION, "/queue/a\\b");
+		frame.body(std::string("bin\0ary", 7));
+		frame.make_payload_append(payload);
+
+		static const char expected[] = "SEND\ndestination:/queue/a\\\\b\nx-escaped:a\\cb\\nc\n\nbin\0ary";
+		STOMP_CHECK_EQ(std::string(payload.begin(), payload.end()), std::string(expected, sizeof(expected)));
+		STOMP_CHECK_EQ(frame.header_block_size() + frame.body().size() + 1, payload.size());
+
+		count = frame.make_payload_segments(head, segments);
+		for (int i = 0; i < count; i++)
+			gathered.insert(gathered.end(), segments[i].data, segments[i].data + segments[i].size);
+		STOMP_CHECK(gathered == payload);
+	}
+
+}
+
+int main() {
+	test_header_escape();
+	test_header_escape_long();
+	test_header_id();
+	test_headers();
+	test_serialize();
+	if (stomp::test::failures()) {
+		fprintf(stderr, "%d check(s) failed\n", stomp::test::failures());
+		return 1;
+	}
+	return 0;
+}
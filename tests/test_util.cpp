@@ -0,0 +1,86 @@
+/**
+ * @file	test_util.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "test_util.hpp"
+
+#include "frame_reader.hpp"
+
+namespace stomp {
+	namespace test {
+
+		int& failures()
+		{
+			static int count = 0;
+			return count;
+		}
+
+		bool read_file(const std::string& path, std::string& out)
+		{
+			FILE* fp = fopen(path.c_str(), "rb");
+			char buf[16384];
+			size_t n;
+			if (!fp)
+				return false;
+			out.clear();
+			while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+				out.append(buf, n);
+			fclose(fp);
+			return true;
+		}
+
+		std::string compare(const Frame& a, const Frame& b)
+		{
+			if (a.command() != b.command())
+				return "command: " + a.command() + " != " + b.command();
+			if (a.header_count() != b.header_count())
+				return a.command() + ": header count " + std::to_string(a.header_count()) + " != " + std::to_string(b.header_count());
+			for (size_t i = 0; i < a.header_count(); i++) {
+				const Frame::HeaderEntry& x = a.header_at(i);
+				const Frame::HeaderEntry& y = b.header_at(i);
+				if ((x.name != y.name) || (x.value != y.value))
+					return a.command() + ": header " + x.name + ":" + x.value + " != " + y.name + ":" + y.value;
+			}
+			if (a.body() != b.body())
+				return a.command() + ": body differs (" + std::to_string(a.body().size()) + " / " + std::to_string(b.body().size()) + " bytes)";
+			return std::string();
+		}
+
+		std::string compare(const FrameList& a, const FrameList& b)
+		{
+			FrameList::const_iterator x = a.begin();
+			FrameList::const_iterator y = b.begin();
+			if (a.size() != b.size())
+				return "frame count " + std::to_string(a.size()) + " != " + std::to_string(b.size());
+			for (size_t index = 0; x != a.end(); x++, y++, index++) {
+				std::string diff = compare(**x, **y);
+				if (!diff.empty())
+					return "frame " + std::to_string(index) + ": " + diff;
+			}
+			return std::string();
+		}
+
+		bool decode_split(const std::string& data, size_t chunk_size, FrameList& out)
+		{
+			FrameReader reader;
+			size_t offset = 0;
+			if (!chunk_size)
+				chunk_size = data.size();
+			while (offset < data.size()) {
+				size_t length = data.size() - offset;
+				if (length > chunk_size)
+					length = chunk_size;
+				reader.decode(data.data() + offset, (int)length, out);
+				if (reader.failed())
+					return false;
+				offset += length;
+			}
+			return true;
+		}
+
+	}
+}
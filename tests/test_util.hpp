@@ -0,0 +1,75 @@
+/**
+ * @file	test_util.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stdio.h>
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "frame.hpp"
+
+namespace stomp {
+	namespace test {
+
+		/**
+		 * Failed CHECKs so far; main() returns non-zero if any.
+		 */
+		int& failures();
+
+		bool read_file(const std::string& path, std::string& out);
+
+		/**
+		 * @return Empty if a and b have the same command, headers (in order) and
+		 *         body, otherwise what differs.
+		 */
+		std::string compare(const Frame& a, const Frame& b);
+
+		typedef std::list< std::unique_ptr<Frame> > FrameList;
+
+		/**
+		 * @return Empty if a and b hold equal frames, otherwise what differs.
+		 */
+		std::string compare(const FrameList& a, const FrameList& b);
+
+		/**
+		 * Decodes data with a fresh FrameReader, chunk_size bytes per decode()
+		 * call (0: all at once).
+		 * @return false if the reader reported an error
+		 */
+		bool decode_split(const std::string& data, size_t chunk_size, FrameList& out);
+
+	}
+}
+
+#define STOMP_CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+			stomp::test::failures()++; \
+		} \
+	} while (false)
+
+#define STOMP_CHECK_EQ(a, b) \
+	do { \
+		if (!((a) == (b))) { \
+			fprintf(stderr, "%s:%d: CHECK failed: %s == %s\n", __FILE__, __LINE__, #a, #b); \
+			stomp::test::failures()++; \
+		} \
+	} while (false)
+
+#define STOMP_CHECK_SAME(diff) \
+	do { \
+		std::string stomp_check_diff = (diff); \
+		if (!stomp_check_diff.empty()) { \
+			fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, stomp_check_diff.c_str()); \
+			stomp::test::failures()++; \
+		} \
+	} while (false)
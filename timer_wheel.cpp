@@ -0,0 +1,151 @@
+/**
+ * @file	timer_wheel.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "timer_wheel.hpp"
+
+namespace stomp {
+
+	TimerWheel::Timer::Timer()
+		: wheel_(NULL), expiry_tick_(0)
+	{
+		prev_ = NULL;
+		next_ = NULL;
+	}
+
+	TimerWheel::Timer::~Timer()
+	{
+		if (wheel_)
+			wheel_->cancel(this);
+	}
+
+	void TimerWheel::link_init(Link* head)
+	{
+		head->prev_ = head;
+		head->next_ = head;
+	}
+
+	void TimerWheel::link_unlink(Link* item)
+	{
+		item->prev_->next_ = item->next_;
+		item->next_->prev_ = item->prev_;
+		item->prev_ = NULL;
+		item->next_ = NULL;
+	}
+
+	void TimerWheel::link_push_back(Link* head, Link* item)
+	{
+		item->prev_ = head->prev_;
+		item->next_ = head;
+		head->prev_->next_ = item;
+		head->prev_ = item;
+	}
+
+	TimerWheel::TimerWheel(clock::duration tick, size_t slot_count)
+		: tick_(tick), start_(clock::now()), current_tick_(0), slots_(slot_count ? slot_count : 1), scheduled_count_(0)
+	{
+		for (size_t i = 0; i < slots_.size(); i++)
+			link_init(&slots_[i]);
+		link_init(&expired_);
+	}
+
+	TimerWheel::~TimerWheel()
+	{
+		// Detach remaining timers so their destructors do not touch this wheel
+		for (size_t i = 0; i < slots_.size(); i++) {
+			while (slots_[i].next_ != &slots_[i])
+				cancel(static_cast<Timer*>(slots_[i].next_));
+		}
+	}
+
+	TimerWheel::clock::duration TimerWheel::tick() const
+	{
+		return tick_;
+	}
+
+	size_t TimerWheel::scheduled_count() const
+	{
+		return scheduled_count_;
+	}
+
+	uint64_t TimerWheel::tick_of(clock::time_point time, bool round_up) const
+	{
+		clock::duration offset = time - start_;
+		if (offset.count() <= 0)
+			return 0;
+		return (uint64_t)((offset + (round_up ? tick_ - clock::duration(1) : clock::duration(0))) / tick_);
+	}
+
+	void TimerWheel::schedule(Timer* timer, clock::time_point deadline)
+	{
+		uint64_t expiry = tick_of(deadline, true);
+		if (timer->wheel_)
+			timer->wheel_->cancel(timer);
+		if (expiry <= current_tick_)
+			expiry = current_tick_ + 1;
+		timer->wheel_ = this;
+		timer->expiry_tick_ = expiry;
+		link_push_back(&slots_[expiry % slots_.size()], timer);
+		scheduled_count_++;
+	}
+
+	void TimerWheel::cancel(Timer* timer)
+	{
+		if (timer->wheel_ != this)
+			return;
+		link_unlink(timer);
+		timer->wheel_ = NULL;
+		scheduled_count_--;
+	}
+
+	void TimerWheel::expire_slot(Link* slot, uint64_t due_tick, int& fired)
+	{
+		Link* item = slot->next_;
+		while (item != slot) {
+			Link* next = item->next_;
+			if (static_cast<Timer*>(item)->expiry_tick_ <= due_tick) {
+				link_unlink(item);
+				link_push_back(&expired_, item);
+			}
+			item = next;
+		}
+		// A callback may cancel or reschedule any timer, including the queued ones
+		while (expired_.next_ != &expired_) {
+			Timer* timer = static_cast<Timer*>(expired_.next_);
+			link_unlink(timer);
+			timer->wheel_ = NULL;
+			scheduled_count_--;
+			timer->onTimer();
+			fired++;
+		}
+	}
+
+	int TimerWheel::advance(clock::time_point now)
+	{
+		uint64_t target = tick_of(now, false);
+		int fired = 0;
+
+		if (target <= current_tick_)
+			return 0;
+
+		if (target - current_tick_ >= slots_.size()) {
+			// Behind by a whole revolution or more: visit every slot once
+			size_t i;
+			current_tick_ = target;
+			for (i = 0; i < slots_.size(); i++)
+				expire_slot(&slots_[(target + 1 + i) % slots_.size()], target, fired);
+			return fired;
+		}
+
+		while (current_tick_ < target) {
+			current_tick_++;
+			expire_slot(&slots_[current_tick_ % slots_.size()], current_tick_, fired);
+		}
+		return fired;
+	}
+
+}
@@ -0,0 +1,99 @@
+/**
+ * @file	timer_wheel.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <vector>
+
+namespace stomp {
+
+	/**
+	 * Hashed timer wheel: scheduling and cancelling are O(1), advance() only
+	 * visits the slots of the elapsed ticks. Deadlines are rounded up to the tick.
+	 * Not thread-safe; schedule, cancel and advance from one (service) thread.
+	 */
+	class TimerWheel {
+	public:
+		typedef std::chrono::steady_clock clock;
+
+		struct Link {
+			Link* prev_;
+			Link* next_;
+		};
+
+		/**
+		 * Intrusive timer entry. A timer is cancelled when destroyed.
+		 */
+		class Timer : private Link {
+		private:
+			friend class TimerWheel;
+
+			TimerWheel* wheel_;
+			uint64_t expiry_tick_;
+
+			Timer(const Timer& o);
+			Timer& operator=(const Timer& o);
+
+		public:
+			Timer();
+			virtual ~Timer();
+
+			bool scheduled() const {
+				return wheel_ != NULL;
+			}
+
+			/**
+			 * Called from advance(). The timer may reschedule itself.
+			 */
+			virtual void onTimer() = 0;
+		};
+
+	private:
+		clock::duration tick_;
+		clock::time_point start_;
+		uint64_t current_tick_;
+		std::vector<Link> slots_;
+		// Due timers of the slot being fired
+		Link expired_;
+		size_t scheduled_count_;
+
+		TimerWheel(const TimerWheel& o);
+		TimerWheel& operator=(const TimerWheel& o);
+
+		static void link_init(Link* head);
+		static void link_unlink(Link* item);
+		static void link_push_back(Link* head, Link* item);
+
+		uint64_t tick_of(clock::time_point time, bool round_up) const;
+		void expire_slot(Link* slot, uint64_t due_tick, int& fired);
+
+	public:
+		TimerWheel(clock::duration tick = std::chrono::milliseconds(100), size_t slot_count = 512);
+		~TimerWheel();
+
+		clock::duration tick() const;
+		size_t scheduled_count() const;
+
+		/**
+		 * (Re)schedules timer to fire at the first tick at or after deadline.
+		 */
+		void schedule(Timer* timer, clock::time_point deadline);
+		void cancel(Timer* timer);
+
+		/**
+		 * Fires every timer whose deadline tick has passed by now.
+		 * @return Number of fired timers
+		 */
+		int advance(clock::time_point now);
+	};
+
+}
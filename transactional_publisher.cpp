@@ -0,0 +1,194 @@
+/**
+ * @file	transactional_publisher.cpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#include "transactional_publisher.hpp"
+
+#include "command/begin.hpp"
+#include "command/commit.hpp"
+#include "command/abort.hpp"
+
+namespace stomp {
+
+	TransactionalPublisher::TransactionalPublisher(Client* client, size_t max_messages, int max_delay_ms, size_t max_bytes)
+		: client_(client),
+		max_messages_(max_messages ? max_messages : 1),
+		max_bytes_(max_bytes),
+		max_delay_(std::chrono::milliseconds(max_delay_ms)),
+		commit_timeout_ms_(get_default_commit_timeout_ms()),
+		message_count_(0),
+		byte_count_(0)
+	{
+	}
+
+	TransactionalPublisher::~TransactionalPublisher()
+	{
+		commit();
+	}
+
+	void TransactionalPublisher::set_commit_callback(const ReceiptTable::Callback& callback, int timeout_ms)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		commit_callback_ = callback;
+		commit_timeout_ms_ = timeout_ms;
+	}
+
+	int TransactionalPublisher::get_default_commit_timeout_ms()
+	{
+		return 5000;
+	}
+
+	int TransactionalPublisher::send(command::Send* item)
+	{
+		return send(item->frame());
+	}
+
+	int TransactionalPublisher::send(Frame* frame)
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		size_t body_size;
+		size_t i;
+		int rc = begin_locked();
+		if (rc)
+			return rc;
+		stamped_.clear();
+		stamped_.command(frame->command());
+		// Added first, so a transaction header of frame loses (first wins)
+		stamped_.header(Frame::HEADER_TRANSACTION, transaction_);
+		for (i = 0; i < frame->header_count(); i++) {
+			const Frame::HeaderEntry& entry = frame->header_at(i);
+			stamped_.header(entry.name, entry.value);
+		}
+		// Borrowed for the send instead of copied
+		stamped_.refValue().swap(frame->refValue());
+		body_size = stamped_.body().size();
+		// Sent under the lock: the SEND frames stay between their BEGIN and COMMIT
+		rc = client_->sendFrame(&stamped_);
+		stamped_.refValue().swap(frame->refValue());
+		if (rc) {
+			abort_locked();
+			return rc;
+		}
+		return sent_locked(body_size, lock);
+	}
+
+	int TransactionalPublisher::commit()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return commit_locked(lock);
+	}
+
+	int TransactionalPublisher::abort()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return abort_locked();
+	}
+
+	int TransactionalPublisher::poll()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		if (due_locked())
+			return commit_locked(lock);
+		return 0;
+	}
+
+	void TransactionalPublisher::reset()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		transaction_.clear();
+		message_count_ = 0;
+		byte_count_ = 0;
+	}
+
+	bool TransactionalPublisher::in_transaction()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return !transaction_.empty();
+	}
+
+	size_t TransactionalPublisher::pending_count()
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		return message_count_;
+	}
+
+	int TransactionalPublisher::begin_locked()
+	{
+		int rc;
+		if (!transaction_.empty())
+			return 0;
+		command::Begin begin(client_, true);
+		rc = client_->sendCommand(&begin);
+		if (rc)
+			return rc;
+		transaction_ = begin.transaction();
+		message_count_ = 0;
+		byte_count_ = 0;
+		begun_at_ = std::chrono::steady_clock::now();
+		return 0;
+	}
+
+	int TransactionalPublisher::sent_locked(size_t body_size, std::unique_lock<std::mutex>& lock)
+	{
+		message_count_++;
+		byte_count_ += body_size;
+		if ((message_count_ >= max_messages_) || (max_bytes_ && (byte_count_ >= max_bytes_)) || due_locked())
+			return commit_locked(lock);
+		return 0;
+	}
+
+	bool TransactionalPublisher::due_locked() const
+	{
+		return !transaction_.empty() && (std::chrono::steady_clock::now() - begun_at_ >= max_delay_);
+	}
+
+	/*
+	 * Unlocks lock before sending: with a callback, COMMIT waits for a slot in
+	 * the receipt window, which only frees up as RECEIPTs arrive.
+	 */
+	int TransactionalPublisher::commit_locked(std::unique_lock<std::mutex>& lock)
+	{
+		ReceiptTable::Callback callback;
+		command::Commit commit(client_);
+		int timeout_ms;
+		int rc;
+		if (transaction_.empty())
+			return 0;
+		commit.transaction(transaction_);
+		callback = commit_callback_;
+		timeout_ms = commit_timeout_ms_;
+		// The transaction is over either way: a COMMIT that could not be sent
+		// leaves it to be dropped with the connection
+		transaction_.clear();
+		message_count_ = 0;
+		byte_count_ = 0;
+		lock.unlock();
+		if (!callback)
+			return client_->sendCommand(&commit);
+		rc = client_->sendCommandWithReceipt(&commit, callback, timeout_ms);
+		if (rc == Client::SEND_TIMEOUT) {
+			// Not left open on the broker until the connection drops
+			command::Abort abort(client_);
+			abort.transaction(commit.transaction());
+			client_->sendCommand(&abort);
+		}
+		return rc;
+	}
+
+	int TransactionalPublisher::abort_locked()
+	{
+		if (transaction_.empty())
+			return 0;
+		command::Abort abort(client_);
+		abort.transaction(transaction_);
+		transaction_.clear();
+		message_count_ = 0;
+		byte_count_ = 0;
+		return client_->sendCommand(&abort);
+	}
+
+}
@@ -0,0 +1,117 @@
+/**
+ * @file	transactional_publisher.hpp
+ * @author	Jichan (development@jc-lab.net / http://ablog.jc-lab.net/ )
+ * @date	2026/10/17
+ * @copyright Copyright (C) 2019 jichan.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+#pragma once
+
+#include <stddef.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include "frame.hpp"
+#include "client.hpp"
+#include "receipt_table.hpp"
+#include "command/send.hpp"
+
+namespace stomp {
+
+	/**
+	 * Groups SEND frames into transactions.
+	 *
+	 * The first send() opens a transaction with BEGIN; every SEND is stamped
+	 * with its transaction header, and COMMIT goes out once max_messages were
+	 * sent, max_bytes of body were sent, or from send() / poll() once the
+	 * transaction is max_delay old. A SEND that fails aborts the transaction.
+	 *
+	 * Brokers persist a committed batch with one store sync instead of one per
+	 * persistent message. Call poll() periodically so a quiet publisher commits
+	 * too.
+	 */
+	class TransactionalPublisher {
+	private:
+		Client* client_;
+		size_t max_messages_;
+		size_t max_bytes_;
+		std::chrono::steady_clock::duration max_delay_;
+		ReceiptTable::Callback commit_callback_;
+		int commit_timeout_ms_;
+
+		std::mutex lock_;
+		// Empty while no transaction is open
+		std::string transaction_;
+		size_t message_count_;
+		size_t byte_count_;
+		std::chrono::steady_clock::time_point begun_at_;
+		// The caller's frame with the transaction header, reused for every send
+		Frame stamped_;
+
+		TransactionalPublisher(const TransactionalPublisher& o);
+		TransactionalPublisher& operator=(const TransactionalPublisher& o);
+
+		int begin_locked();
+		int sent_locked(size_t body_size, std::unique_lock<std::mutex>& lock);
+		int commit_locked(std::unique_lock<std::mutex>& lock);
+		int abort_locked();
+		bool due_locked() const;
+
+	public:
+		/**
+		 * @param client       Client the frames are sent with
+		 * @param max_messages SEND frames per transaction
+		 * @param max_delay_ms Longest a transaction stays open
+		 * @param max_bytes    Body bytes per transaction, 0 for no limit
+		 */
+		TransactionalPublisher(Client* client, size_t max_messages = 100, int max_delay_ms = 100, size_t max_bytes = 0);
+		/**
+		 * Commits what is pending.
+		 */
+		~TransactionalPublisher();
+
+		/**
+		 * Sends COMMIT with a receipt; callback runs with its outcome.
+		 * Without a callback COMMIT is sent without a receipt. COMMIT goes out
+		 * after the publisher is unlocked, as it may wait up to timeout_ms
+		 * (negative: no limit) for the receipt window; if the window stays full
+		 * the transaction is aborted instead and the commit returns SEND_TIMEOUT.
+		 */
+		void set_commit_callback(const ReceiptTable::Callback& callback, int timeout_ms = get_default_commit_timeout_ms());
+		static int get_default_commit_timeout_ms();
+
+		/**
+		 * Sends item inside the current transaction, opening one if needed. The
+		 * frame itself is left as it was; a copy of its headers carries the
+		 * transaction header.
+		 * @return SEND_OK or the send error; on error the transaction is aborted.
+		 */
+		int send(command::Send* item);
+		int send(Frame* frame);
+
+		int commit();
+		/**
+		 * Aborts the open transaction; the broker discards its SEND frames.
+		 */
+		int abort();
+		/**
+		 * Commits if the open transaction is due.
+		 */
+		int poll();
+		/**
+		 * Forgets the open transaction without sending anything, e.g. after the
+		 * connection was lost and the broker dropped it already.
+		 */
+		void reset();
+
+		bool in_transaction();
+		/**
+		 * SEND frames in the open transaction.
+		 */
+		size_t pending_count();
+	};
+
+}